@@ -1,30 +1,64 @@
 #pragma once
-#define CL_HPP_TARGET_OPENCL_VERSION 300
-#define CL_HPP_ENABLE_EXCEPTIONS
-#include <CL/opencl.hpp>
+#include <atomic>
+#include <chrono>
 #include <filesystem>
 #include <string_view>
+#include <thread>
 #include <vector>
 #include <tuple>
+#include <memory>
+#include "BufferPool.hpp"
+#include "DeviceRunner.hpp"
+#include "MemoryBudget.hpp"
+#include "ProgramCache.hpp"
+#include "Settings.hpp"
+#include "TableResults.hpp"
+#include "TestScheduler.hpp"
 #include "TestVector.hpp"
+#include "TuningDatabase.hpp"
 
 namespace Tester {
 
 class Application {
  public:
-    Application();
+    explicit Application(Settings settings = {});
 
     void parseTestFolder(std::filesystem::path pathToTests);
     void runTests();
    
  private:
-    std::vector<uint8_t> run_host_gpu(const Test& test);
+    // Data column of a variant on a device
+    struct Column {
+        std::string name;
+        const Test::Variant* variant;
+        const DeviceRunner* device;
+        std::optional<double> time;  // empty if the variant didn't run
+        const DispatchResult* result = nullptr;
+    };
+    void printColumnsReport(const Test& test, const std::vector<Column>& columns,
+                            const std::vector<TestStatistic>& stats) const;
+    // Passing cases of every column of a batched test
+    void printCasesReport(const Test& test, const std::vector<Column>& columns) const;
+    void printSummary() const;
+    void startBuilds();
+    void buildWorker();
 
-    Test::GPUVenderType m_vendor = Test::GPUVenderType::NVIDIA;
-    cl::Program compileProgram(std::string_view kernal);
-    cl::Platform m_platform;
-    cl::Context m_context;
-    cl::CommandQueue m_queue;
+    Settings m_settings;
+    std::unique_ptr<ProgramCache> m_program_cache;
+    std::unique_ptr<TuningDatabase> m_tuning_db;
+    std::unique_ptr<MemoryBudget> m_host_memory;
+    std::vector<std::unique_ptr<MemoryBudget>> m_device_memory;  // one per device, shared by its sub-devices
+    std::unique_ptr<BufferPool> m_buffer_pool;                    // null if buffer_allocation is "none"
+    std::vector<std::unique_ptr<DeviceRunner>> m_devices;
+    std::vector<size_t> m_device_groups;  // devices of a group share a scheduler and split the tests
+    std::vector<std::unique_ptr<TestScheduler>> m_schedulers;
     std::vector<Test> m_tests;
+
+    // Compile stage: every variant of every test is built for every device by m_build_workers
+    std::vector<std::vector<Test::Variant>> m_variants;
+    std::vector<std::tuple<size_t, size_t, size_t>> m_build_jobs;  // device id, test id, variant id in build order
+    std::atomic<size_t> m_next_build = 0;
+    std::chrono::steady_clock::time_point m_builds_start;
+    std::vector<std::jthread> m_build_workers;  // declared last: joined before the OpenCL objects are released
 };
 }  // namespace Tester
@@ -0,0 +1,44 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Tester {
+
+// CL_PROFILING_COMMAND_QUEUED/SUBMIT/START/END of one dispatch, ns
+struct TimingSample {
+    uint64_t queued = 0;
+    uint64_t submit = 0;
+    uint64_t start = 0;
+    uint64_t end = 0;
+};
+
+// Kernel time and launch latency statistics over benchmark iterations, microseconds
+struct TimingStatistic {
+    size_t iterations = 0;
+    double min = 0;
+    double median = 0;
+    double mean = 0;
+    double p95 = 0;
+    double stddev = 0;
+    double cv = 0;                // stddev / mean
+    double ci95 = 0;              // half-width of the 95% confidence interval of the mean
+    double queue_to_start = 0;    // mean QUEUED -> START
+    double submit_to_start = 0;   // mean SUBMIT -> START
+
+    static TimingStatistic calculate(const std::vector<TimingSample>& samples);
+};
+
+// Fixed cost of a dispatch measured with an empty kernel, microseconds
+struct TimingCalibration {
+    double timer_resolution = 0;  // CL_DEVICE_PROFILING_TIMER_RESOLUTION
+    double empty_kernel = 0;      // median START -> END of an empty kernel
+    double launch_overhead = 0;   // mean QUEUED -> START of an empty kernel
+
+    double correct(double kernel_time) const noexcept { return std::max(kernel_time - empty_kernel, 0.0); }
+    // Kernel time without the empty kernel time is too short for the device timer to measure
+    bool isReliable(double kernel_time) const noexcept { return correct(kernel_time) >= timer_resolution; }
+};
+
+}  // namespace Tester
@@ -0,0 +1,67 @@
+#pragma once
+#define CL_HPP_TARGET_OPENCL_VERSION 300
+#define CL_HPP_ENABLE_EXCEPTIONS
+#include <CL/opencl.hpp>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "MemoryBudget.hpp"
+
+namespace Tester {
+
+// Device buffers reused across dispatches, idle buffers are kept per context and size class.
+// A request is rounded up to its class (4, 5, 6 or 7 times a power of two, at most 25% larger) and takes an idle
+// buffer of the class if there is one, a class above the max allocation size of the device isn't used: the request
+// gets a buffer of its exact size. Pooled buffers are READ_WRITE, so a buffer serves any argument.
+// Idle buffers beyond idle_limit bytes are released, the rest are idle bytes of the budget of their device and
+// are dropped when the budget reclaims them (trim). Thread-safe.
+class BufferPool final {
+ public:
+    struct Statistic {
+        size_t requests = 0;
+        size_t reused = 0;
+        size_t allocations = 0;
+        size_t sub_buffers = 0;
+        uintmax_t allocated_bytes = 0;
+        uintmax_t peak_idle_bytes = 0;
+        uintmax_t trimmed_bytes = 0;
+    };
+    // One pooled buffer carved into sub-buffers
+    struct Arena {
+        cl::Buffer buffer;               // goes back to the pool, the slices must not be used after it
+        std::vector<cl::Buffer> slices;  // one per requested size
+    };
+
+    explicit BufferPool(uintmax_t idle_limit);
+
+    static size_t getSizeClass(size_t bytes);
+    // Bytes acquire() allocates for the request, max_alloc is CL_DEVICE_MAX_MEM_ALLOC_SIZE of the context
+    static size_t getAllocationSize(size_t bytes, size_t max_alloc);
+    // Bytes of the slices with their padding, the arena allocates getAllocationSize() of it
+    static size_t getArenaSize(const std::vector<size_t>& sizes, size_t alignment);
+    cl::Buffer acquire(const cl::Context& context, size_t bytes, size_t max_alloc);
+    // Slices start at multiples of alignment bytes (CL_DEVICE_MEM_BASE_ADDR_ALIGN of the devices of the context),
+    // the arena size must not exceed max_alloc
+    Arena acquireArena(const cl::Context& context, const std::vector<size_t>& sizes, size_t alignment,
+                       size_t max_alloc);
+    // Every command that uses the buffer must have finished, the buffer is kept if it fits the budget
+    void release(const cl::Context& context, cl::Buffer buffer, MemoryBudget& budget);
+    // Drops the idle buffers of the context
+    void trim(const cl::Context& context);
+    Statistic getStatistic() const;
+
+ private:
+    struct IdleBuffer {
+        cl::Buffer buffer;
+        MemoryBudget* budget;  // charged for the size class of the buffer
+    };
+    uintmax_t m_idle_limit;
+    uintmax_t m_idle_bytes = 0;
+    mutable std::mutex m_mutex;
+    std::map<std::pair<cl_context, size_t>, std::vector<IdleBuffer>> m_idle;  // context, size class -> buffers
+    Statistic m_statistic;
+};
+
+}  // namespace Tester
@@ -0,0 +1,31 @@
+#pragma once
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Tester {
+
+// OpenCL C source file together with every header it includes, directly or transitively.
+// hash covers the source and the whole include graph, so changing a header changes the hash
+// of its dependents only.
+// A ".spv" file is loaded as a SPIR-V module into il instead, it has neither source nor headers.
+struct CompileUnit {
+    using header_type = std::pair<std::string, std::string>;  // include name, header source
+
+    std::string name;
+    std::string source;
+    std::vector<header_type> headers;
+    std::vector<char> il;
+    std::string hash;
+
+    // Headers are searched in the folder of the including file and then in include_dirs
+    static CompileUnit load(const std::filesystem::path& path, const std::vector<std::filesystem::path>& include_dirs);
+    // Copy with every ${NAME} in the source and headers replaced by the value of parameter NAME
+    CompileUnit specialize(const std::vector<std::pair<std::string, std::string>>& parameters) const;
+
+ private:
+    void updateHash();
+};
+
+}  // namespace Tester
@@ -0,0 +1,239 @@
+#pragma once
+#define CL_HPP_TARGET_OPENCL_VERSION 300
+#define CL_HPP_ENABLE_EXCEPTIONS
+#include <CL/opencl.hpp>
+#include <array>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Benchmark.hpp"
+#include "BufferPool.hpp"
+#include "InputCache.hpp"
+#include "MemoryBudget.hpp"
+#include "ProgramCache.hpp"
+#include "Settings.hpp"
+#include "TestScheduler.hpp"
+#include "TestVector.hpp"
+#include "TuningDatabase.hpp"
+
+namespace Tester {
+
+struct CompiledProgram {
+    cl::Program program;
+    std::chrono::microseconds build_time{0};
+    std::chrono::microseconds frontend_time{0};  // OpenCL C -> compiled objects
+    std::chrono::microseconds backend_time{0};   // SPIR-V build, link -> executable
+    bool from_cache = false;
+    std::chrono::steady_clock::time_point finish_time;
+    std::string id;  // sources of the program with headers and libraries, see getProgramId
+};
+
+// Output of a variant on one device, empty if the variant didn't run
+struct DispatchResult {
+    std::vector<Test::output_blob> outputs;  // one per output buffer of the test
+    double kernel_time_us = 0;  // median of the benchmark in benchmark mode
+    std::optional<TimingStatistic> timing;
+};
+
+// Every variant of a test on one device with the report of the device about them
+struct TestResult {
+    std::vector<DispatchResult> variants;
+    std::string log;
+};
+
+// Context, queues, compile stage and dispatch pipeline of one OpenCL device.
+// build() is called by the build workers of Application, runTests() by the host thread of the device,
+// results of the tests are taken in order with getResult() from any other thread.
+class DeviceRunner final {
+ public:
+    // device_memory is shared by the sub-devices of a device, host_memory and buffer_pool by every runner
+    DeviceRunner(cl::Device device, std::string label, const Settings& settings, ProgramCache* program_cache,
+                 TuningDatabase* tuning_db, MemoryBudget& device_memory, MemoryBudget& host_memory,
+                 BufferPool* buffer_pool);
+
+    const std::string& getLabel() const noexcept { return m_label; };
+    std::string getName() const { return m_device.getInfo<CL_DEVICE_NAME>(); };
+    cl_device_type getType() const noexcept { return m_type; };
+    // "GPU", "CPU", "ACC" or "DEV", prefix of the device labels
+    static std::string getTypeName(cl_device_type type);
+    bool isSupported(const Test& test) const noexcept;
+    // The runner builds the tests dealt to it upfront, the tests it steals are built when taken
+    bool isDealt(size_t test_id) const noexcept { return m_scheduler->getDealtWorker(test_id) == m_worker; };
+    // Blocks until a runner of the group has taken the test
+    bool isScheduled(size_t test_id) const { return m_scheduler->getWorker(test_id) == m_worker; };
+    void calibrate();
+    // Overhead-corrected time and the unreliable flag to print after a raw kernel time, empty if not calibrated
+    std::string formatCorrectedTime(double kernel_time_us) const;
+
+    // Tests, variants and the scheduler must outlive the runner's compile and run stages,
+    // worker is the index of the runner in the group of the scheduler
+    void prepare(const std::vector<Test>& tests, const std::vector<std::vector<Test::Variant>>& variants,
+                 TestScheduler& scheduler, size_t worker);
+    void build(size_t test_id, size_t variant_id);
+    void runTests();
+    // Blocks until the device has finished the test
+    const TestResult& getResult(size_t test_id) const;
+    std::chrono::steady_clock::time_point getLastBuildFinish() const;
+    void printSummary(std::chrono::steady_clock::time_point builds_start) const;
+
+ private:
+    // Device side of a variant run: upload -> kernel -> readback chained by events
+    struct Dispatch {
+        cl::Kernel kernel;
+        std::vector<cl::Buffer> inputs;
+        std::vector<cl::Buffer> outputs;  // one per output buffer, an in-place one is its input
+        std::vector<size_t> global;
+        std::vector<size_t> local;
+        bool tuned = false;
+        std::vector<cl::Event> upload_events;
+        std::vector<cl::Event> resident_events;  // uploads of the inputs bound from the input cache
+        // Pins of the input cache entries the dispatch binds, their bytes are idle bytes of the cache
+        std::vector<std::shared_ptr<const void>> resident_pins;
+        uintmax_t resident_bytes = 0;                            // bound from the input cache
+        std::vector<std::pair<size_t, cl::Event>> cache_misses;  // uploaded inputs the input cache may keep
+        cl::Event kernel_event;
+        std::vector<cl::Event> read_events;
+        cl::Event read_event;                         // every readback has finished
+        std::vector<Test::output_blob> host_outputs;  // written by the readbacks, zero-copy outputs wrap them
+        // Chunked dispatch: kernel_event is the last kernel
+        std::vector<cl::Buffer> chunk_buffers;
+        std::vector<cl::Event> chunk_kernel_events;
+        std::vector<cl::Buffer> pooled;  // returned to the buffer pool once the reservation is released
+        std::vector<void*> mapped;       // zero-copy outputs mapped by the readbacks
+    };
+    // Runs the finished dispatch again with coarse- and, if supported, fine-grained SVM allocations, compares their
+    // outputs and times with the buffers. The buffers of the dispatch are released, nothing else is in flight
+    void compareSvm(const Test& test, const Test::Variant& variant, Dispatch& dispatch, const DispatchResult& result,
+                    std::ostream& log);
+    void runSvm(const Test& test, const Test::Variant& variant, Dispatch& dispatch, const DispatchResult& result,
+                bool fine_grain, std::ostream& log);
+    // Device buffer of every size with its flags, as buffer_allocation says
+    std::vector<cl::Buffer> allocateBuffers(const std::vector<std::pair<size_t, cl_mem_flags>>& buffers,
+                                            Dispatch& dispatch);
+    // Pooled buffers share one arena buffer, unless the arena would exceed the max allocation size
+    bool isArena(const std::vector<std::pair<size_t, cl_mem_flags>>& buffers) const;
+    // Device bytes allocateBuffers() allocates for the buffers: size classes or the padded arena when pooled
+    uintmax_t getAllocationSize(const std::vector<std::pair<size_t, cl_mem_flags>>& buffers) const;
+    // Enqueues without blocking, empty if the variant can't run
+    std::optional<Dispatch> enqueueDispatch(const Test& test, const Test::Variant& variant,
+                                            const CompiledProgram& compiled, cl::CommandQueue& queue,
+                                            std::ostream& log);
+    // Inserts the uploaded inputs of cache_misses into the input cache, returns the bytes the cache keeps
+    uintmax_t cacheInputs(const Test& test, Dispatch& dispatch);
+    // Waits for the readback, reports and benchmarks the variant
+    DispatchResult finishDispatch(const Test& test, const Test::Variant& variant, const CompiledProgram& compiled,
+                                  Dispatch& dispatch, std::ostream& log);
+    // Output elements of a chunk of an out-of-core dispatch, empty if the test runs in one piece
+    std::optional<size_t> getChunkElements(const Test& test) const;
+    struct ChunkLayout {
+        size_t total_items = 0;
+        size_t chunk_items = 0;                               // a whole number of work-groups
+        std::vector<std::pair<size_t, cl_mem_flags>> buffers;  // of a buffer set, inputs and then outputs
+    };
+    ChunkLayout getChunkLayout(const Test& test, const Test::Variant& variant, size_t chunk_elements) const;
+    // Device bytes a dispatch of the variant allocates while in flight, the input cache holds some of them once
+    // the dispatch is enqueued
+    uintmax_t getFootprint(const Test& test, const Test::Variant& variant) const;
+    // Host bytes the readbacks of a dispatch in flight write: every output, whole for a chunked dispatch too, its
+    // chunks are read back in place. The blobs of the test are loaded whole and aren't counted
+    uintmax_t getHostFootprint(const Test& test) const;
+    // Dispatches the index space chunk by chunk with global offsets, uploads and readbacks of the next and
+    // previous chunks overlap the kernel through two sets of buffers
+    void enqueueChunks(const Test& test, const Test::Variant& variant, size_t chunk_elements,
+                       cl::CommandQueue& queue, Dispatch& dispatch);
+    size_t getPipelineDepth() const noexcept;
+    // "auto" global size is output elements / items per work-item
+    std::vector<size_t> getGlobalSize(const Test& test, const Test::Variant& variant, size_t output_elements) const;
+    // Throws if the local size doesn't fit the kernel and device limits, empty local size is always valid
+    void checkLocalSize(const cl::Kernel& kernel, const std::vector<size_t>& global,
+                        const std::vector<size_t>& local) const;
+    std::vector<std::vector<size_t>> getLocalSizeCandidates(const cl::Kernel& kernel,
+                                                            const std::vector<size_t>& global) const;
+    // Runs every candidate local size, returns the fastest one whose outputs match the goldens
+    std::optional<TuningDatabase::Entry> autotune(const Test& test, const cl::Kernel& kernel,
+                                                  const std::vector<size_t>& global,
+                                                  const std::vector<cl::Buffer>& outputs, std::ostream& log);
+    // Warmup and timed dispatches of benchmark mode
+    TimingStatistic benchmark(const cl::Kernel& kernel, const cl::NDRange& offset, const cl::NDRange& global,
+                              const cl::NDRange& local);
+
+    struct CompiledObject {
+        cl::Program program;
+        std::chrono::microseconds compile_time{0};  // zero if another test compiled the unit
+        bool is_il = false;
+    };
+    CompiledProgram compileProgram(const Test& test, const Test::Variant& variant);
+    void linkProgram(const Test& test, const CompileUnit& program, const std::string& options,
+                     CompiledProgram& compiled);
+    CompiledObject getCompiledObject(const CompileUnit& unit, const std::string& options);
+    cl::Program compileObject(const CompileUnit& unit, const std::string& options);
+
+    const Settings& m_settings;
+    std::string m_label;
+    std::optional<Test::GPUVenderType> m_vendor;
+    cl_device_type m_type = CL_DEVICE_TYPE_DEFAULT;
+    cl_uint m_compute_units = 0;
+    bool m_il_supported = false;
+    cl::Device m_device;
+    cl::Context m_context;
+    cl::CommandQueue m_queue;
+    std::vector<cl::CommandQueue> m_queues;  // pipeline queues, m_queue if no in-order queues are requested
+    ProgramCache* m_program_cache;           // shared by the devices, may be null
+    TuningDatabase* m_tuning_db;             // shared by the devices, may be null
+    MemoryBudget& m_device_memory;
+    MemoryBudget& m_host_memory;
+    BufferPool* m_buffer_pool;               // shared by the devices, may be null
+    size_t m_base_addr_align = 1;            // bytes, sub-buffers of an arena start at its multiples
+    size_t m_max_alloc = 0;                  // CL_DEVICE_MAX_MEM_ALLOC_SIZE
+    bool m_zero_copy = false;
+    cl_device_svm_capabilities m_svm_capabilities = 0;
+    std::unique_ptr<InputCache> m_input_cache;  // null if input_cache_size is 0 or in zero-copy mode
+    // Zero-copy buffers of the input blobs of the tests in flight, one per blob
+    std::unordered_map<const uint8_t*, cl::Buffer> m_wrapped_inputs;
+    std::optional<TimingCalibration> m_calibration;
+
+    const std::vector<Test>* m_tests = nullptr;
+    const std::vector<std::vector<Test::Variant>>* m_variants = nullptr;
+    TestScheduler* m_scheduler = nullptr;
+    size_t m_worker = 0;
+
+    // Compiled objects of program and library units, keyed by include graph hash and options
+    std::mutex m_objects_mutex;
+    std::unordered_map<std::string, std::shared_future<cl::Program>> m_objects;
+
+    // m_builds[i][j] is the program of test i built as its variant j
+    std::vector<std::vector<std::promise<CompiledProgram>>> m_build_promises;
+    std::vector<std::vector<std::shared_future<CompiledProgram>>> m_builds;
+    std::chrono::microseconds m_build_wait_time{0};
+
+    // m_results[i] is set once every variant of test i has finished
+    std::vector<std::promise<TestResult>> m_result_promises;
+    std::vector<std::shared_future<TestResult>> m_results;
+
+    std::vector<std::pair<cl_ulong, cl_ulong>> m_device_intervals;  // START, END of every pipeline command
+    size_t m_tests_run = 0;
+    size_t m_dispatch_count = 0;
+    size_t m_memory_stalls = 0;  // dispatches that waited for the memory of the dispatches in flight
+    uintmax_t m_uploaded_bytes = 0;
+    uintmax_t m_resident_bytes = 0;  // input bytes bound from the input cache instead of uploaded
+    uintmax_t m_wrapped_bytes = 0;   // input bytes the zero-copy dispatches used in place
+    // Dispatches compared in SVM mode, times in Microseconds
+    struct SvmComparison {
+        size_t dispatches = 0;
+        size_t mismatches = 0;
+        double svm_transfer = 0;
+        double svm_kernel = 0;
+        double buffer_transfer = 0;
+        double buffer_kernel = 0;
+    };
+    std::array<SvmComparison, 2> m_svm;  // coarse-grained, fine-grained
+    std::chrono::microseconds m_run_time{0};
+};
+
+}  // namespace Tester
@@ -0,0 +1,64 @@
+#pragma once
+#define CL_HPP_TARGET_OPENCL_VERSION 300
+#define CL_HPP_ENABLE_EXCEPTIONS
+#include <CL/opencl.hpp>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include "MemoryBudget.hpp"
+
+namespace Tester {
+
+// Read-only input buffers resident on one device context, keyed by the hash of their blob (Test::getInputHash).
+// The least recently used buffers are dropped once the resident bytes exceed the limit. Resident bytes are idle
+// bytes of the device budget, the budget drops the buffers when it reclaims them (clear). A dispatch in flight
+// pins the entries it binds: they stay resident and counted until it drops the pins. Thread-safe.
+class InputCache final {
+ public:
+    struct Entry {
+        cl::Buffer buffer;
+        cl::Event upload;                 // the kernels that bind the buffer wait for it
+        std::shared_ptr<const void> pin;  // the entry isn't dropped while a copy exists
+    };
+    struct Statistic {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t evicted = 0;
+        uintmax_t peak_bytes = 0;
+    };
+
+    InputCache(uintmax_t size_limit, MemoryBudget& budget);
+    ~InputCache();
+
+    // Empty on a miss, the entry is pinned
+    std::optional<Entry> find(const std::string& hash);
+    // The bytes are reserved in the budget by the caller and become idle bytes if the entry is kept. Empty if the
+    // entry isn't kept: a blob larger than the limit or than the bytes the pinned entries leave, the entry is pinned
+    std::optional<Entry> insert(const std::string& hash, uintmax_t bytes, Entry entry);
+    // Drops the entries that aren't pinned
+    void clear();
+    Statistic getStatistic() const;
+
+ private:
+    // False if every entry is pinned
+    bool evictOldest();
+
+    struct Slot {
+        Entry entry;
+        uintmax_t bytes;
+        std::list<std::string>::iterator use;
+    };
+    uintmax_t m_size_limit;
+    MemoryBudget& m_budget;
+    uintmax_t m_bytes = 0;
+    mutable std::mutex m_mutex;
+    std::list<std::string> m_uses;  // hashes, the most recently used first
+    std::unordered_map<std::string, Slot> m_slots;
+    Statistic m_statistic;
+};
+
+}  // namespace Tester
@@ -0,0 +1,49 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Tester {
+
+// Bytes the dispatches in flight may hold in one memory: a device (shared by its sub-devices) or the host.
+// A runner that holds a reservation must not block in acquire(), it finishes its dispatches instead,
+// so the blocked runners hold nothing and every reservation is eventually released.
+// Idle bytes are held by caches for later dispatches (idle pooled buffers, resident inputs), they are used
+// memory until the reclaimers drop them. Thread-safe.
+class MemoryBudget final {
+ public:
+    MemoryBudget(std::string name, uintmax_t limit);
+
+    const std::string& getName() const noexcept { return m_name; };
+    uintmax_t getLimit() const noexcept { return m_limit; };
+    bool tryAcquire(uintmax_t bytes);
+    // Blocks until the bytes fit, reclaims the idle bytes first, bytes must not exceed the limit
+    void acquire(uintmax_t bytes);
+    void release(uintmax_t bytes);
+    bool tryAcquireIdle(uintmax_t bytes);
+    // Acquired bytes a cache keeps once the dispatch is done with them
+    void convertToIdle(uintmax_t bytes);
+    void releaseIdle(uintmax_t bytes);
+    // Reclaimer releases the idle bytes its cache holds in the memory and doesn't use, added before the runners
+    // start
+    void addReclaimer(std::function<void()> reclaimer);
+    // Runs every reclaimer, false if there were no idle bytes
+    bool reclaim();
+    // Peak of the bytes of the dispatches in flight, without the idle bytes
+    uintmax_t getPeak() const;
+
+ private:
+    std::string m_name;
+    uintmax_t m_limit;
+    uintmax_t m_used = 0;  // with the idle bytes
+    uintmax_t m_idle = 0;
+    uintmax_t m_peak = 0;
+    std::vector<std::function<void()>> m_reclaimers;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_released;
+};
+
+}  // namespace Tester
@@ -0,0 +1,46 @@
+#pragma once
+#define CL_HPP_TARGET_OPENCL_VERSION 300
+#define CL_HPP_ENABLE_EXCEPTIONS
+#include <CL/opencl.hpp>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Tester {
+
+// Content-addressed directory of CL_PROGRAM_BINARIES.
+// Every entry is "<key>.bin", where key = MD5(source, build options, device name, driver version).
+// Last write time of an entry is its last use, so eviction removes the least recently used binaries
+// until the directory fits into the size limit. All methods are thread-safe.
+class ProgramCache final {
+ public:
+    struct Statistic {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t evicted = 0;
+        uintmax_t size = 0;  // bytes on disk after the last store
+    };
+
+    ProgramCache(std::filesystem::path directory, uintmax_t size_limit);
+
+    static std::string makeKey(std::string_view source, std::string_view options, const cl::Device& device);
+
+    std::optional<std::vector<unsigned char>> load(const std::string& key);
+    void store(const std::string& key, const std::vector<unsigned char>& binary);
+    void invalidate(const std::string& key);
+    Statistic getStatistic() const;
+
+ private:
+    std::filesystem::path getEntryPath(const std::string& key) const;
+    void evict();
+
+    std::filesystem::path m_directory;
+    uintmax_t m_size_limit;
+    Statistic m_statistic;
+    mutable std::mutex m_mutex;
+};
+
+}  // namespace Tester
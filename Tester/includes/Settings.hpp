@@ -0,0 +1,83 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace Tester {
+
+struct Settings {
+    // Devices the tests run on: device_type is "all", "gpu", "cpu" or "accelerator", platform and device filters
+    // are case-insensitive regexes searched in the names, device_index picks one of the matching devices.
+    // If no device matches, every CPU device is used when cpu_fallback is set
+    std::string device_type = "all";
+    std::string platform_filter;
+    std::string device_filter;
+    std::optional<size_t> device_index;
+    bool cpu_fallback = true;
+    // Sub-devices of every selected device, tests are distributed across them:
+    // "equally:N" - N compute units each, "counts:A,B,..." - A, B, ... compute units,
+    // "affinity:numa|l4|l3|l2|l1|next" - by affinity domain, "" - devices aren't partitioned
+    std::string partition;
+    // Every test runs once, on the device that frees up first, instead of on every device
+    bool distribute_tests = false;
+
+    // Persistent cache of built program binaries (see ProgramCache)
+    bool use_program_cache = true;
+    std::filesystem::path program_cache_dir = ".cl_cache";
+    uintmax_t program_cache_size_limit = 256ull * 1024 * 1024;  // bytes
+
+    // Host threads of the compile stage, 0 - one per hardware thread
+    unsigned int build_threads = 0;
+
+    // Build option sets swept for every test, replace "BuildOptions" of the test JSON when not empty
+    std::vector<std::string> build_option_sets;
+
+    // Local work sizes of tests with "auto" LocalSize are taken from the tuning database (see TuningDatabase),
+    // autotune sweeps them again and stores the fastest passing ones
+    bool use_tuning_db = true;
+    std::filesystem::path tuning_db_path = "tuning.json";
+    bool autotune = false;
+
+    // Variants enqueued ahead of the one whose results the host checks, 0 - one variant at a time
+    unsigned int pipeline_depth = 2;
+    // In-order queues tests are distributed across, 0 - a single out-of-order queue
+    unsigned int queue_count = 0;
+
+    // Buffers of the dispatches in flight are limited to this share of CL_DEVICE_GLOBAL_MEM_SIZE on every device
+    // and to host_memory_budget bytes of readbacks on the host, 0 - unlimited
+    unsigned int device_memory_percent = 80;
+    uintmax_t host_memory_budget = 1024ull * 1024 * 1024;
+    // Buffer size limit of a chunk of the "Chunked" tests, 0 - CL_DEVICE_MAX_MEM_ALLOC_SIZE.
+    // A chunked test whose buffers fit the limit and the device budget runs in one piece
+    uintmax_t chunk_size = 0;
+    // Device buffers of a dispatch: "pool" - taken from the buffer pool (see BufferPool), "arena" - one pooled
+    // buffer split into sub-buffers, "none" - a new buffer per argument. Idle pooled buffers are kept up to
+    // buffer_pool_limit bytes
+    std::string buffer_allocation = "pool";
+    uintmax_t buffer_pool_limit = 256ull * 1024 * 1024;
+    // Read-only inputs stay resident on every device up to this many bytes and are bound again by the tests
+    // with equal blobs instead of uploaded (see InputCache), 0 - every input is uploaded
+    uintmax_t input_cache_size = 256ull * 1024 * 1024;
+    // Zero-copy dispatches wrap the input blobs in place (CL_MEM_USE_HOST_PTR) and map the outputs instead of
+    // copying them: "auto" - on devices with CL_DEVICE_HOST_UNIFIED_MEMORY, "on" or "off"
+    std::string zero_copy = "auto";
+    // Every dispatch runs again with coarse-grained clSVMAlloc allocations, and fine-grained ones where supported,
+    // and its transfer and kernel times are compared with the buffer dispatch. Dispatches aren't pipelined
+    bool svm = false;
+
+    // Benchmark mode: every variant is dispatched warmup_iterations times and then timed.
+    // benchmark_iterations = 0 - repeat until the 95% confidence interval of the mean is within
+    // benchmark_precision of the mean, but at least min and at most max benchmark iterations
+    bool benchmark = false;
+    // Empty kernel and timer resolution are measured before the tests to correct kernel times
+    bool calibrate = true;
+    unsigned int warmup_iterations = 3;
+    unsigned int benchmark_iterations = 0;
+    unsigned int min_benchmark_iterations = 30;
+    unsigned int max_benchmark_iterations = 1000;
+    double benchmark_precision = 0.02;
+};
+
+}  // namespace Tester
@@ -28,8 +28,10 @@ class TableResults final {
     void addDataColumn(std::string_view column_name, std::vector<data_type> data);
     template<typename data_type>
     void addAdditionalInfoColumn(std::string_view column_name, std::vector<data_type> data);
+    // Kernel time of a data column, shown with its difference from the golden column
+    void setColumnTime(std::string_view column_name, double microseconds);
 
-    void processAndShow();
+    TestStatistic processAndShow();
     void clear();
     using Variant_types_vec = std::variant<
         std::vector<uint64_t>,
@@ -54,11 +56,13 @@ class TableResults final {
     void drawTextLine(std::string&& str, unsigned int lineSize) const;
     void drawTextLineLeft(std::string&& str, unsigned int lineSize) const;
     void drawNextData(const std::vector<Variant_types_vec>& data, const size_t i) const;
+    void drawColumnsSummary(const TestStatistic& stats) const;
     TestStatistic getStatistics(size_t size);
     std::string getHash(size_t index);
     void reset();
     std::vector<std::string> m_columns_names;
     std::vector<std::string> m_info_columns_names;
+    std::vector<std::optional<double>> m_columns_time;
     std::vector<Variant_types_vec> m_columns_data;
     std::vector<Variant_types_vec> m_columns_data_unconverted;
     std::vector<Variant_types_vec> m_info_columns_data;
@@ -76,6 +80,7 @@ inline void TableResults::addDataColumn(std::string_view column_name, std::vecto
 
     m_columns_names.emplace_back(column_name);
     m_columns_data.emplace_back(data);
+    m_columns_time.emplace_back();
 }
 
 template<typename data_type>
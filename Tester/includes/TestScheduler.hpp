@@ -0,0 +1,49 @@
+#pragma once
+#include <chrono>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace Tester {
+
+// Tests shared by a group of workers (devices or sub-devices that split the suite between them).
+// Tests are dealt to the worker deques in turn, every worker takes tests from the front of its own deque and,
+// once it is empty, steals from the back of the longest one: the front tests are built first, the stolen ones last.
+// Thread-safe, one lock is enough for test-sized jobs.
+class TestScheduler final {
+ public:
+    static constexpr size_t no_worker = static_cast<size_t>(-1);
+    struct WorkerStatistic {
+        size_t tests = 0;
+        size_t stolen = 0;
+    };
+
+    TestScheduler(size_t workers, size_t tests);
+
+    size_t getWorkersCount() const noexcept { return m_statistics.size(); }
+    // Worker the test is dealt to
+    size_t getDealtWorker(size_t test_id) const noexcept { return test_id % m_statistics.size(); }
+    // Empty when every deque is empty
+    std::optional<size_t> next(size_t worker);
+    // The worker takes no more tests, the tests nobody has taken after the last worker retired go to no_worker
+    void retire();
+    // Blocks until a worker has taken the test
+    size_t getWorker(size_t test_id) const;
+    WorkerStatistic getStatistic(size_t worker) const;
+    // From the first taken test to the last retired worker
+    std::chrono::microseconds getWallTime() const;
+
+ private:
+    mutable std::mutex m_mutex;
+    std::vector<std::deque<size_t>> m_deques;
+    std::vector<WorkerStatistic> m_statistics;
+    size_t m_retired = 0;
+    std::vector<std::promise<size_t>> m_worker_promises;
+    std::vector<std::shared_future<size_t>> m_workers;
+    std::optional<std::chrono::steady_clock::time_point> m_start;
+    std::chrono::steady_clock::time_point m_finish;
+};
+
+}  // namespace Tester
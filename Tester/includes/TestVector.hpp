@@ -3,34 +3,134 @@
 #include <vector>
 #include <string>
 #include <filesystem>
+#include <new>
+#include <optional>
+#include <span>
+#include "CompileUnit.hpp"
 
 namespace fs = std::filesystem;
 
 namespace Tester {
+// Page-aligned storage, a zero-copy device wraps it in place (CL_MEM_USE_HOST_PTR)
+template<typename T>
+struct PageAllocator {
+    using value_type = T;
+    static constexpr std::align_val_t alignment{4096};
+    PageAllocator() = default;
+    template<typename U>
+    PageAllocator(const PageAllocator<U>&) noexcept {}
+    T* allocate(size_t n) { return static_cast<T*>(::operator new(n * sizeof(T), alignment)); }
+    void deallocate(T* p, size_t) noexcept { ::operator delete(p, alignment); }
+    template<typename U>
+    bool operator==(const PageAllocator<U>&) const noexcept { return true; }
+};
+
 class Test {
  public:
     enum class GPUVenderType { AMD, NVIDIA, INTEL };
     enum class blob_type { float32, uint32 };
-    using input_type = std::tuple<std::string, blob_type, std::vector<uint8_t>>;
+    using input_blob = std::vector<uint8_t, PageAllocator<uint8_t>>;
+    // Output of a dispatch, page-aligned so that a zero-copy device writes it in place
+    using output_blob = std::vector<uint8_t, PageAllocator<uint8_t>>;
+    using input_type = std::tuple<std::string, blob_type, input_blob>;
     using output_type = std::pair<std::string, std::tuple<std::string, blob_type, std::vector<uint8_t>>>;
-    Test(std::filesystem::path&& to_test_path, std::vector<input_type>&& inputs, std::vector<output_type>&& output,
-         std::string&& prog, std::string&& test_name, GPUVenderType type);
+    // Output argument of the kernel, compared with every golden of its "Buffer".
+    // Kernel arguments are the inputs and then the output buffers, an in-place buffer is bound as its input only
+    struct OutputBuffer {
+        std::string name;                  // empty for the single output of a test without "Buffer"
+        std::vector<output_type> goldens;  // equal sizes, the first one is the reference of the report
+        std::optional<size_t> in_place;    // input the kernel updates in place ("InPlace" of the input)
+        blob_type getType() const { return std::get<1>(goldens.front().second); };
+        size_t getSize() const { return std::get<2>(goldens.front().second).size(); };
+    };
+    // Values of template parameters, substituted for ${NAME} in the source and defined with -D
+    struct Specialization {
+        std::vector<std::pair<std::string, std::string>> parameters;
+        size_t items_per_work_item = 1;  // global size is divided by it
+    };
+    // One build of the test program, every variant is built, run and compared separately
+    struct Variant {
+        std::string name;     // column name in the results table
+        std::string options;  // appended to the default build options
+        Specialization specialization;
+    };
+    // Kernel argument in "Arguments" order, without "Arguments" - the inputs and then the outputs that aren't in place
+    struct Argument {
+        enum class Kind { input, output, scalar, local };
+        Kind kind;
+        size_t index = 0;                    // input or output buffer
+        blob_type type = blob_type::uint32;  // scalar type
+        std::string value;                   // scalar value or local bytes, may use ${NAME} parameters and "*"
+    };
+    // Case of a batched test ("Cases"): the blobs of every case are concatenated and run in one dispatch,
+    // so the kernel must be elementwise like a "Chunked" one
+    struct Case {
+        std::string name;
+        std::vector<std::pair<size_t, size_t>> outputs;  // byte offset and size of the case in every output buffer
+    };
+    // Sizes of the dispatch by dimension, empty - "auto":
+    // global size is output elements / items per work-item, local size is chosen by the driver (NullRange)
+    struct NDRangeSizes {
+        std::vector<size_t> global;
+        std::vector<size_t> local;
+        std::vector<size_t> offset;
+    };
+    Test(std::filesystem::path&& to_test_path, std::vector<input_type>&& inputs, std::vector<OutputBuffer>&& outputs,
+         CompileUnit&& prog, std::vector<CompileUnit>&& libraries, std::string&& test_name,
+         std::optional<GPUVenderType> type);
     const std::vector<input_type>& getInputs() const noexcept { return m_inputs; };
-    const std::vector<output_type>& getOutputs() const noexcept { return m_outputs; };
-    const std::string& getProgram() const noexcept { return m_opencl_program; };
+    // MD5 of the input blob, tests with equal inputs share the device buffer of the input cache
+    const std::string& getInputHash(size_t input) const { return m_input_hashes.at(input); };
+    const std::vector<OutputBuffer>& getOutputs() const noexcept { return m_outputs; };
+    const std::vector<Argument>& getArguments() const noexcept { return m_arguments; };
+    // Empty if the test isn't batched
+    const std::vector<Case>& getCases() const noexcept { return m_cases; };
+    // Cases whose part of the outputs doesn't match the first golden of its buffer
+    std::vector<std::string> getFailedCases(const std::vector<output_blob>& outputs) const;
+    // Same rule as TableResults: floats may differ by epsilon, other types must be equal
+    static bool matchesGolden(blob_type type, std::span<const uint8_t> golden, std::span<const uint8_t> result);
+    // Bytes of a scalar argument and size of a local one for the specialization
+    static std::vector<uint8_t> getScalar(const Argument& argument, const Specialization& specialization);
+    static size_t getLocalSize(const Argument& argument, const Specialization& specialization);
+    const CompileUnit& getProgram() const noexcept { return m_opencl_program; };
+    const std::vector<CompileUnit>& getLibraries() const noexcept { return m_libraries; };
+    bool isIL() const noexcept { return !m_opencl_program.il.empty(); };
+    const NDRangeSizes& getNDRange() const noexcept { return m_ndrange; };
+    // Bytes of the device buffers of a dispatch: every input and every output that isn't in place
+    size_t getFootprint() const noexcept;
+    // "Chunked": elementwise kernel that may run out-of-core, a work-item touches only its own elements of every blob.
+    // The buffers are indexed with get_global_id(0) - get_global_offset(0), chunks are dispatched with offsets
+    bool isChunked() const noexcept { return m_chunked; };
+    // Every build option set with every specialization, option_sets replace the sets of the test when not empty
+    std::vector<Variant> getVariants(const std::vector<std::string>& option_sets = {}) const;
     const std::string& getName() const noexcept { return m_name; };
     static blob_type getBlobType(std::string_view type);
     static uint32_t getTypeSize(blob_type type);
-    GPUVenderType getVenderType() const { return m_vendor; };
-    static Test parseTest(std::filesystem::path pathToTest);
+    // Vendor the test is written for, empty - runs on every device
+    std::optional<GPUVenderType> getVenderType() const { return m_vendor; };
+    // common_folder: suite-level folder with shared libraries and headers
+    static Test parseTest(std::filesystem::path pathToTest, const std::filesystem::path& common_folder = {});
 
  private:
     void fillBlobs();
-    GPUVenderType m_vendor = GPUVenderType::NVIDIA;
+    void loadBlobs(std::vector<input_type>& inputs, std::vector<OutputBuffer>& outputs) const;
+    void hashInputs();
+    // Appends the blobs of a case with the layout of the first one
+    void appendCase(std::string name, std::vector<input_type>&& inputs, std::vector<OutputBuffer>&& outputs);
+    std::optional<GPUVenderType> m_vendor;
     std::filesystem::path m_to_test_path;
-    std::string m_opencl_program;
+    CompileUnit m_opencl_program;
+    std::vector<CompileUnit> m_libraries;
+    std::vector<std::string> m_build_option_sets = {""};
+    std::string m_defines;
+    std::vector<Specialization> m_specializations = {Specialization{}};
+    NDRangeSizes m_ndrange;
+    bool m_chunked = false;
     std::string m_name;
     std::vector<input_type> m_inputs;
-    std::vector<output_type> m_outputs;
+    std::vector<std::string> m_input_hashes;
+    std::vector<OutputBuffer> m_outputs;
+    std::vector<Argument> m_arguments;
+    std::vector<Case> m_cases;
 };
 }  // namespace Tester
\ No newline at end of file
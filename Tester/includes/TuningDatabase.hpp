@@ -0,0 +1,36 @@
+#pragma once
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Tester {
+
+// JSON file with the best local work size found by --autotune for every (kernel, global size, device).
+// Keys are built by the caller, an empty local size means "auto" (NullRange) was the fastest.
+// Thread-safe, the devices share one database.
+class TuningDatabase final {
+ public:
+    struct Entry {
+        std::vector<size_t> local_size;
+        double kernel_time_us = 0;
+        std::string test_name;    // informational, to make the file readable
+        std::string device_name;  // informational, the key already identifies the device
+    };
+
+    explicit TuningDatabase(std::filesystem::path path);
+
+    std::optional<Entry> find(const std::string& key) const;
+    void update(const std::string& key, Entry entry);
+    void save() const;
+    size_t size() const;
+
+ private:
+    std::filesystem::path m_path;
+    mutable std::mutex m_mutex;
+    std::unordered_map<std::string, Entry> m_entries;
+};
+
+}  // namespace Tester
@@ -1,80 +1,192 @@
 #include "Application.hpp"
 
 #include "TableResults.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
 #include <exception>
 #include <filesystem>
 #include <iostream>
+#include <map>
+#include <regex>
+#include <span>
+#include <sstream>
 #include <string>
 
 namespace {
-cl::Platform get_platform() {
+cl_device_type parseDeviceType(std::string type) {
+    std::transform(type.begin(), type.end(), type.begin(), [](unsigned char c) { return std::tolower(c); });
+    if (type == "all") return CL_DEVICE_TYPE_ALL;
+    if (type == "gpu") return CL_DEVICE_TYPE_GPU;
+    if (type == "cpu") return CL_DEVICE_TYPE_CPU;
+    if (type == "accelerator") return CL_DEVICE_TYPE_ACCELERATOR;
+    throw std::runtime_error("Unknown device type: \"" + type + "\", expected all, gpu, cpu or accelerator");
+}
+
+// Devices of the type whose platform and device names contain a match of the filters, empty filter matches all
+std::vector<cl::Device> getDevices(cl_device_type type, const std::string& platform_filter,
+                                   const std::string& device_filter) {
+    const std::regex platform_regex(platform_filter, std::regex::icase);
+    const std::regex device_regex(device_filter, std::regex::icase);
     std::vector<cl::Platform> platforms;
     cl::Platform::get(&platforms);
+    std::vector<cl::Device> devices;
     for (auto& p : platforms) {
-        cl_uint numDevices = 0;
-        clGetDeviceIDs(p(), CL_DEVICE_TYPE_GPU, 0, nullptr, &numDevices);
-        if (numDevices > 0) return cl::Platform(p);
+        if (!std::regex_search(p.getInfo<CL_PLATFORM_NAME>(), platform_regex)) continue;
+        std::vector<cl::Device> platform_devices;
+        try {
+            p.getDevices(type, &platform_devices);
+        } catch (const std::exception&) { continue; }  // CL_DEVICE_NOT_FOUND
+        for (auto& device : platform_devices) {
+            if (std::regex_search(device.getInfo<CL_DEVICE_NAME>(), device_regex)) devices.push_back(device);
+        }
     }
-    throw std::runtime_error("Can't find suitable opencl platform");
-    return {};
+    return devices;
 }
 
-cl::Context get_context(cl_platform_id p_id) {
-    cl_context_properties properties[] = {CL_CONTEXT_PLATFORM, reinterpret_cast<cl_context_properties>(p_id), 0};
-    return cl::Context(CL_DEVICE_TYPE_GPU, properties);
+// "equally:N", "counts:A,B,..." or "affinity:numa|l4|l3|l2|l1|next" -> properties of clCreateSubDevices
+std::vector<cl_device_partition_property> parsePartition(const std::string& partition) {
+    const auto colon = partition.find(':');
+    const auto kind = partition.substr(0, colon);
+    const auto value = colon == std::string::npos ? std::string() : partition.substr(colon + 1);
+    if (kind == "equally" && !value.empty()) return {CL_DEVICE_PARTITION_EQUALLY, std::stol(value), 0};
+    if (kind == "counts" && !value.empty()) {
+        std::vector<cl_device_partition_property> properties = {CL_DEVICE_PARTITION_BY_COUNTS};
+        std::istringstream counts(value);
+        for (std::string count; std::getline(counts, count, ',');) { properties.push_back(std::stol(count)); }
+        properties.push_back(CL_DEVICE_PARTITION_BY_COUNTS_LIST_END);
+        properties.push_back(0);
+        return properties;
+    }
+    static const std::map<std::string, cl_device_affinity_domain> domains = {
+        {"numa", CL_DEVICE_AFFINITY_DOMAIN_NUMA},         {"l4", CL_DEVICE_AFFINITY_DOMAIN_L4_CACHE},
+        {"l3", CL_DEVICE_AFFINITY_DOMAIN_L3_CACHE},       {"l2", CL_DEVICE_AFFINITY_DOMAIN_L2_CACHE},
+        {"l1", CL_DEVICE_AFFINITY_DOMAIN_L1_CACHE},       {"next", CL_DEVICE_AFFINITY_DOMAIN_NEXT_PARTITIONABLE}};
+    if (auto domain = domains.find(value); kind == "affinity" && domain != domains.end()) {
+        return {CL_DEVICE_PARTITION_BY_AFFINITY_DOMAIN, static_cast<cl_device_partition_property>(domain->second), 0};
+    }
+    throw std::runtime_error("Unknown partition: \"" + partition +
+                             "\", expected equally:N, counts:A,B,... or affinity:numa|l4|l3|l2|l1|next");
 }
 
-const cl::QueueProperties getQueueProperties() noexcept {
-    return cl::QueueProperties::Profiling | cl::QueueProperties::OutOfOrder;
+// Sub-devices of the device, the device itself if it can't be partitioned this way
+std::vector<cl::Device> partitionDevice(cl::Device& device,
+                                        const std::vector<cl_device_partition_property>& partition) {
+    const auto supported = device.getInfo<CL_DEVICE_PARTITION_PROPERTIES>();
+    std::vector<cl::Device> sub_devices;
+    if (std::find(supported.begin(), supported.end(), partition.front()) != supported.end()) {
+        try {
+            device.createSubDevices(partition.data(), &sub_devices);
+        } catch (const std::exception& e) {
+            std::cout << "Warning: clCreateSubDevices error: " << e.what() << std::endl;
+            sub_devices.clear();
+        }
+    }
+    if (sub_devices.empty()) {
+        std::cout << "Warning: device \"" << device.getInfo<CL_DEVICE_NAME>()
+                  << "\" can't be partitioned this way, the whole device is used" << std::endl;
+        return {device};
+    }
+    return sub_devices;
+}
+
+std::vector<cl::Device> selectDevices(const Tester::Settings& settings) {
+    auto devices = getDevices(parseDeviceType(settings.device_type), settings.platform_filter, settings.device_filter);
+    if (devices.empty() && settings.cpu_fallback) {
+        devices = getDevices(CL_DEVICE_TYPE_CPU, "", "");
+        if (!devices.empty()) std::cout << "Warning: no device matches the selection, using CPU devices" << std::endl;
+    } else if (settings.device_index.has_value() && !devices.empty()) {
+        if (*settings.device_index >= devices.size()) {
+            throw std::runtime_error("Device index " + std::to_string(*settings.device_index) + " is out of range, " +
+                                     std::to_string(devices.size()) + " devices match the selection");
+        }
+        devices = {devices[*settings.device_index]};
+    }
+    if (devices.empty()) throw std::runtime_error("Can't find suitable opencl platform");
+    return devices;
 }
 
 template<typename T>
-std::vector<T> convertBuffer(const std::vector<uint8_t>& buffer) {
+std::vector<T> convertBuffer(std::span<const uint8_t> buffer) {
     std::vector<T> convertedBuffer(buffer.size() / sizeof(T));
     std::memcpy(convertedBuffer.data(), buffer.data(), buffer.size());
     return convertedBuffer;
 }
+
+void addDataColumn(Tester::TableResults& table, Tester::Test::blob_type type, const std::string& name,
+                   std::span<const uint8_t> buffer) {
+    switch (type) {
+        case Tester::Test::blob_type::float32: table.addDataColumn(name, convertBuffer<float>(buffer)); break;
+        case Tester::Test::blob_type::uint32: table.addDataColumn(name, convertBuffer<uint32_t>(buffer)); break;
+        default: break;
+    }
+}
 }  // namespace
 
 namespace Tester {
-Application::Application()
-    : m_platform(get_platform()), m_context(get_context(m_platform())), m_queue(m_context, getQueueProperties()) {
-    const auto name = m_platform.getInfo<CL_PLATFORM_NAME>();
-    const auto profile = m_platform.getInfo<CL_PLATFORM_PROFILE>();
-    const auto version = m_platform.getInfo<CL_PLATFORM_VERSION>();
-    const auto vendor = m_platform.getInfo<CL_PLATFORM_VENDOR>();
-    std::vector<cl_name_version> extentions;
-    try {
-        extentions = m_platform.getInfo<CL_PLATFORM_EXTENSIONS_WITH_VERSION>();
-    } catch (const std::exception& e) { std::cerr << "OpenCL get extentions error: " << e.what() << std::endl; }
-
-    auto end_npos = std::string::npos;
-    if (vendor.find("NVIDIA") != end_npos || vendor.find("nvidia") != end_npos) {
-        m_vendor = Test::GPUVenderType::NVIDIA;
-    }
-    if (vendor.find("AMD") != end_npos || vendor.find("amd") != end_npos ||
-        vendor.find("Advanced Micro Devices") != end_npos) {
-        m_vendor = Test::GPUVenderType::AMD;
-    }
-    if (vendor.find("INTEL") != end_npos || vendor.find("intel") != end_npos) {
-        m_vendor = Test::GPUVenderType::INTEL;
-    }
-    std::cout << "Selected platform: " << name << "\nVersion: " << version << ", Profile: " << profile
-              << "\nVendor:  " << vendor << std::endl
-              << std::endl;
-
-    for (const auto& ext : extentions) {
-        if (std::string(ext.name) == "cl_khr_fp16") std::cout << "Supported fp16 extention" << std::endl;
+Application::Application(Settings settings) : m_settings(std::move(settings)) {
+    if (m_settings.use_program_cache) {
+        try {
+            m_program_cache = std::make_unique<ProgramCache>(m_settings.program_cache_dir,
+                                                             m_settings.program_cache_size_limit);
+        } catch (const std::exception& e) {
+            std::cout << "Warning: program cache is disabled! " << e.what() << std::endl;
+        }
+    }
+    if (m_settings.use_tuning_db || m_settings.autotune) {
+        m_tuning_db = std::make_unique<TuningDatabase>(m_settings.tuning_db_path);
+    }
+
+    // Every device or sub-device gets its own context, a device that can't be used is skipped
+    const auto partition = m_settings.partition.empty() ? std::vector<cl_device_partition_property>{}
+                                                        : parsePartition(m_settings.partition);
+    const auto host_budget = m_settings.host_memory_budget ? m_settings.host_memory_budget : UINTMAX_MAX;
+    m_host_memory = std::make_unique<MemoryBudget>("Host", host_budget);
+    if (m_settings.buffer_allocation == "pool" || m_settings.buffer_allocation == "arena") {
+        m_buffer_pool = std::make_unique<BufferPool>(m_settings.buffer_pool_limit);
+    } else if (m_settings.buffer_allocation != "none") {
+        throw std::runtime_error("Unknown buffer allocation: " + m_settings.buffer_allocation);
+    }
+    if (m_settings.zero_copy != "auto" && m_settings.zero_copy != "on" && m_settings.zero_copy != "off") {
+        throw std::runtime_error("Zero-copy should be auto, on or off: " + m_settings.zero_copy);
     }
+    size_t device_index = 0;
+    for (auto& device : selectDevices(m_settings)) {
+        const auto label =
+            DeviceRunner::getTypeName(device.getInfo<CL_DEVICE_TYPE>()) + " " + std::to_string(device_index++);
+        const uintmax_t global_memory = device.getInfo<CL_DEVICE_GLOBAL_MEM_SIZE>();
+        m_device_memory.push_back(std::make_unique<MemoryBudget>(
+            label, m_settings.device_memory_percent ? global_memory / 100 * m_settings.device_memory_percent
+                                                    : UINTMAX_MAX));
+        const auto sub_devices =
+            partition.empty() ? std::vector<cl::Device>{device} : partitionDevice(device, partition);
+        for (size_t i = 0; i < sub_devices.size(); ++i) {
+            try {
+                m_devices.push_back(std::make_unique<DeviceRunner>(
+                    sub_devices[i], sub_devices.size() > 1 ? label + "." + std::to_string(i) : label, m_settings,
+                    m_program_cache.get(), m_tuning_db.get(), *m_device_memory.back(), *m_host_memory,
+                    m_buffer_pool.get()));
+                // Sub-devices of a device split its tests, distributed tests are split by every device
+                m_device_groups.push_back(m_settings.distribute_tests ? 0 : device_index - 1);
+            } catch (const std::exception& e) {
+                std::cout << "Warning: device \"" << device.getInfo<CL_DEVICE_NAME>() << "\" is skipped. Error: "
+                          << e.what() << std::endl;
+            }
+        }
+    }
+    if (m_devices.empty()) throw std::runtime_error("Can't create context for any opencl device");
 }
 
 void Application::parseTestFolder(std::filesystem::path pathToTests) {
+    m_build_workers.clear();  // a running compile stage reads m_tests
     pathToTests.make_preferred();
     if (pathToTests.empty()) { throw std::runtime_error("parseTests: path is empty!"); }
     if (!std::distance(fs::directory_iterator(pathToTests), fs::directory_iterator{})) {
         throw std::runtime_error("parseTests: Directory is empty!\n\tDirectory: " + pathToTests.string());
     }
+    const auto common_folder = pathToTests / "Common";
     for (const auto& entry : fs::directory_iterator(pathToTests)) {
+        if (entry.path() == common_folder) continue;  // shared libraries and headers, not a test
         if (!entry.is_directory()) {
             std::cout << "Warning! \"Tests\" directory contains file!: " << entry.path().filename() << std::endl;
             continue;
@@ -83,121 +195,229 @@ void Application::parseTestFolder(std::filesystem::path pathToTests) {
             std::cout << "Warning!: Test Directory is empty!\n\tDirectory: " << entry << std::endl;
             continue;
         }
-        m_tests.emplace_back(Test::parseTest(entry));
+        m_tests.emplace_back(Test::parseTest(entry, fs::is_directory(common_folder) ? common_folder : fs::path{}));
     }
+    startBuilds();
 }
 
-std::vector<uint8_t> Application::run_host_gpu(const Test& test) {
-    std::vector<cl::Buffer> input_buffers;
-    cl::Buffer output_buffer;
-
-    cl::Program program = compileProgram(test.getProgram());
-    cl::Kernel kernel;
-    try {
-        kernel = cl::Kernel(program, test.getName().c_str());
-    } catch (const std::exception& e) {
-        std::cerr << "Error during kernel creation! Test: " << test.getName() << "\nError : " << e.what() << std::endl;
-        return {};
+void Application::startBuilds() {
+    m_variants.clear();
+    m_build_jobs.clear();
+    for (const auto& test : m_tests) { m_variants.push_back(test.getVariants(m_settings.build_option_sets)); }
+    m_schedulers.clear();
+    std::map<size_t, std::vector<DeviceRunner*>> groups;
+    for (size_t device_id = 0; device_id < m_devices.size(); ++device_id) {
+        groups[m_device_groups[device_id]].push_back(m_devices[device_id].get());
     }
-
-    for (auto& input_info = test.getInputs(); auto& input : input_info) {
-        auto& buffer = std::get<2>(input);
-        cl::Buffer buf(m_context, CL_MEM_READ_ONLY, buffer.size());
-        cl::copy(m_queue, buffer.data(), buffer.data() + buffer.size(), buf);
-        input_buffers.emplace_back(std::move(buf));
-        kernel.setArg(input_buffers.size() - 1, input_buffers.back());
+    for (auto& [group, devices] : groups) {
+        m_schedulers.push_back(std::make_unique<TestScheduler>(devices.size(), m_tests.size()));
+        for (size_t worker = 0; worker < devices.size(); ++worker) {
+            devices[worker]->prepare(m_tests, m_variants, *m_schedulers.back(), worker);
+        }
     }
-    auto& output_info = test.getOutputs();
-    if (output_info.empty()) {
-        std::cout << "Warning: output blobs for test: \"" << test.getName() << "\" are empty !" << std::endl;
-        return {};
+    for (size_t test_id = 0; test_id < m_tests.size(); ++test_id) {
+        for (size_t variant_id = 0; variant_id < m_variants[test_id].size(); ++variant_id) {
+            for (size_t device_id = 0; device_id < m_devices.size(); ++device_id) {
+                if (!m_devices[device_id]->isDealt(test_id)) continue;
+                m_build_jobs.emplace_back(device_id, test_id, variant_id);
+            }
+        }
     }
-    auto& buffer = std::get<2>(output_info.front().second);
-    output_buffer = cl::Buffer(m_context, CL_MEM_WRITE_ONLY, buffer.size());
-    kernel.setArg(input_buffers.size(), output_buffer);
+    m_next_build = 0;
+    m_builds_start = std::chrono::steady_clock::now();
 
-    const auto output_size = std::get<2>(output_info[0].second).size();
-    const auto output_type = std::get<1>(output_info[0].second);
-
-    cl::NDRange GlobalRange(output_size / Test::getTypeSize(output_type));
-    cl::NDRange LocalRange(1);
-    cl::EnqueueArgs Args(m_queue, GlobalRange, LocalRange);
+    size_t workers_count = m_settings.build_threads;
+    if (workers_count == 0) workers_count = std::max(std::thread::hardware_concurrency(), 1u);
+    workers_count = std::min(workers_count, m_build_jobs.size());
+    for (size_t i = 0; i < workers_count; ++i) { m_build_workers.emplace_back(&Application::buildWorker, this); }
+}
 
-    cl::KernelFunctor functor(kernel);
-    cl::Event evt;
-    try {
-        evt = functor(Args);
-        evt.wait();
-    } catch (const std::exception& e) {
-        std::cerr << "Error during dispatch! Test: " << test.getName() << "\nError : " << e.what() << std::endl;
-        return {};
+void Application::buildWorker() {
+    // Tests are taken in order, so the first tests are ready first and runTests starts without waiting for the rest
+    for (size_t i = m_next_build++; i < m_build_jobs.size(); i = m_next_build++) {
+        const auto [device_id, test_id, variant_id] = m_build_jobs[i];
+        m_devices[device_id]->build(test_id, variant_id);
     }
-
-    std::vector<uint8_t> host_result_buffer(output_size);
-
-    cl::copy(m_queue, output_buffer, host_result_buffer.begin(), host_result_buffer.end());
-
-    auto GPUTimeStart = evt.getProfilingInfo<CL_PROFILING_COMMAND_START>();  // in ns
-    auto GPUTimeFin = evt.getProfilingInfo<CL_PROFILING_COMMAND_END>();
-    auto GDur = (GPUTimeFin - GPUTimeStart) / 1000;  // ns -> s
-    std::cout << "\nTest: " << test.getName() << std::endl;
-    std::cout << "System GPU: Vertex shader pure time measured: " << GDur << " Microseconds" << std::endl;
-
-    return host_result_buffer;
 }
 
 void Application::runTests() {
-    for (auto& test : m_tests) {
-        TableResults table(test.getName(), 15, 6, 16);
-
-        auto& outputs = test.getOutputs();
-        const auto output_size = std::get<2>(outputs.front().second).size();
-        const auto output_type = std::get<1>(outputs.front().second);
-
-        auto addDataColumn = [&](const std::string& name, const std::vector<uint8_t>& buf) {
-            switch (output_type) {
-                case Test::blob_type::float32: table.addDataColumn(name, convertBuffer<float>(buf)); break;
-                case Test::blob_type::uint32: table.addDataColumn(name, convertBuffer<uint32_t>(buf)); break;
-                default: break;
+    if (m_settings.calibrate) {
+        for (auto& device : m_devices) {
+            try {
+                device->calibrate();
+            } catch (const std::exception& e) {
+                std::cout << "Warning: calibration of " << device->getLabel()
+                          << " failed, kernel times aren't corrected. Error: " << e.what() << std::endl;
             }
-        };
+        }
+    }
+    {
+        // Every device runs the whole suite on its own host thread, tables are shown here in test order
+        std::vector<std::jthread> device_threads;
+        for (auto& device : m_devices) { device_threads.emplace_back(&DeviceRunner::runTests, device.get()); }
 
-        for (auto& output : outputs) { addDataColumn(output.first, std::get<2>(output.second)); }
+        for (size_t test_id = 0; test_id < m_tests.size(); ++test_id) {
+            auto& test = m_tests[test_id];
+            const auto& variants = m_variants[test_id];
+            // One table per output buffer, its goldens come first
+            const auto& buffers = test.getOutputs();
+            std::vector<TableResults> tables;
+            for (const auto& buffer : buffers) {
+                const auto table_name = buffers.size() > 1 ? test.getName() + ": " + buffer.name : test.getName();
+                auto& table = tables.emplace_back(table_name, 15, 6, 16);
+                for (const auto& golden : buffer.goldens) {
+                    addDataColumn(table, std::get<1>(golden.second), golden.first, std::get<2>(golden.second));
+                }
+            }
 
-        //Run test on host device
-        if (m_vendor == test.getVenderType()) {
-            auto host_result_buffer = run_host_gpu(test);
-            if (!host_result_buffer.empty()) { addDataColumn("Host GPU", host_result_buffer); }
+            // One column per device and variant
+            std::vector<Column> columns;
+            for (const auto& device : m_devices) {
+                if (!device->isScheduled(test_id)) continue;
+                try {
+                    const auto& result = device->getResult(test_id);
+                    std::cout << result.log;
+                    if (!device->isSupported(test)) continue;
+                    for (size_t variant_id = 0; variant_id < variants.size(); ++variant_id) {
+                        const auto& variant_result = result.variants[variant_id];
+                        auto name = device->getLabel();
+                        if (!variants[variant_id].name.empty()) name += " " + variants[variant_id].name;
+                        columns.push_back({name, &variants[variant_id], device.get(), std::nullopt});
+                        if (variant_result.outputs.empty()) continue;
+                        for (size_t b = 0; b < buffers.size(); ++b) {
+                            addDataColumn(tables[b], buffers[b].getType(), name, variant_result.outputs[b]);
+                        }
+                        columns.back().time = variant_result.kernel_time_us;
+                        columns.back().result = &variant_result;
+                    }
+                } catch (const std::exception& e) {
+                    std::cerr << "Error on " << device->getLabel() << "! Test: " << test.getName()
+                              << "\nError : " << e.what() << std::endl;
+                }
+            }
+            if (columns.size() > 1) {
+                for (const auto& column : columns) {
+                    if (!column.time.has_value()) continue;
+                    for (auto& table : tables) { table.setColumnTime(column.name, *column.time); }
+                }
+            }
+            try {
+                std::vector<TestStatistic> stats;
+                for (auto& table : tables) { stats.push_back(table.processAndShow()); }
+                if (!test.getCases().empty()) printCasesReport(test, columns);
+                if (columns.size() > 1) printColumnsReport(test, columns, stats);
+            } catch (const std::exception& e) {
+                std::cout << "TableException, Test: " << test.getName() << std::endl << "Error: "
+                << e.what() << std::endl;
+            }
         }
-        try {
-            table.processAndShow();
-        } catch (const std::exception& e) {
-            std::cout << "TableException, Test: " << test.getName() << std::endl << "Error: "
-            << e.what() << std::endl;
+    }
+    if (m_settings.autotune && m_tuning_db) m_tuning_db->save();
+    printSummary();
+}
+
+void Application::printColumnsReport(const Test& test, const std::vector<Column>& columns,
+                                     const std::vector<TestStatistic>& stats) const {
+    // Every input is read and every output is written once per dispatch
+    size_t bytes = 0;
+    for (const auto& input : test.getInputs()) { bytes += std::get<2>(input).size(); }
+    for (const auto& output : test.getOutputs()) { bytes += output.getSize(); }
+
+    // diffs[i] compares data column i + 1 with the golden column 0, device columns follow the goldens.
+    // A column passes when it matches in every output table
+    std::vector<bool> passed(columns.size(), true);
+    for (size_t b = 0; b < stats.size(); ++b) {
+        size_t data_column = test.getOutputs()[b].goldens.size();
+        for (size_t i = 0; i < columns.size(); ++i) {
+            if (!columns[i].time.has_value()) {
+                passed[i] = false;
+                continue;
+            }
+            passed[i] = passed[i] && stats[b].diffs.at(data_column++ - 1).mismatch_count == 0;
+        }
+    }
+    // The fastest passing CPU column is the baseline of the speedups
+    std::optional<double> cpu_time;
+    for (size_t i = 0; i < columns.size(); ++i) {
+        if (!passed[i] || !(columns[i].device->getType() & CL_DEVICE_TYPE_CPU)) continue;
+        if (!cpu_time.has_value() || *columns[i].time < *cpu_time) cpu_time = columns[i].time;
+    }
+
+    std::optional<size_t> fastest;
+    for (size_t i = 0; i < columns.size(); ++i) {
+        const auto& column = columns[i];
+        std::cout << column.name << ": \"" << column.variant->options << "\"";
+        if (!column.time.has_value()) {
+            std::cout << ", not run" << std::endl;
+            continue;
         }
+        std::cout << ", " << *column.time << " Microseconds" << column.device->formatCorrectedTime(*column.time)
+                  << ", " << bytes / (*column.time * 1000.0) << " GB/s";
+        if (cpu_time.has_value() && passed[i]) std::cout << ", " << *cpu_time / *column.time << "x vs CPU";
+        std::cout << ", " << (passed[i] ? "PASS" : "DIFF") << std::endl;
+        if (passed[i] && (!fastest.has_value() || *column.time < *columns[*fastest].time)) fastest = i;
+    }
+    if (fastest.has_value()) {
+        const auto& column = columns[*fastest];
+        std::cout << "Fastest passing: " << column.name << " \"" << column.variant->options << "\", " << *column.time
+                  << " Microseconds" << std::endl;
+    } else {
+        std::cout << "No passing variants!" << std::endl;
     }
 }
 
-cl::Program Application::compileProgram(std::string_view kernel) {
-    cl::Program program(m_context, kernel.data());
-    try {
-        program.build("-Werror");  // see https://man.opencl.org/clBuildProgram.html
-    } catch (const std::exception& e) {
-        std::stringstream ss;
-        ss << "\ncompileProgram(..) error: \n";
-        ss << "Exception: \"" << e.what() << "\"" << std::endl;
-        ss << "Reason:\n";
-        auto buildInfo = program.getBuildInfo<CL_PROGRAM_BUILD_LOG>();
-        for (auto& [device, error] : buildInfo) {
-            ss << "Program build log for device \"" << device.getInfo<CL_DEVICE_NAME>()
-               << "\"\nwith compiler arguments: \"" << program.getBuildInfo<CL_PROGRAM_BUILD_OPTIONS>(device)
-               << "\"\nKernal: " << program.getInfo<CL_PROGRAM_SOURCE>() << std::endl
-               << "Compilation error: \n"
-               << error << std::endl;
+void Application::printCasesReport(const Test& test, const std::vector<Column>& columns) const {
+    constexpr size_t max_listed = 10;
+    const auto& cases = test.getCases();
+    for (const auto& column : columns) {
+        if (column.result == nullptr) continue;
+        const auto failed = test.getFailedCases(column.result->outputs);
+        std::cout << column.name << ": " << cases.size() - failed.size() << " of " << cases.size() << " cases pass";
+        for (size_t i = 0; i < failed.size() && i < max_listed; ++i) {
+            std::cout << (i == 0 ? ", failed: " : ", ") << failed[i];
         }
-        throw std::runtime_error(ss.str());
+        if (failed.size() > max_listed) std::cout << ", ...";
+        std::cout << std::endl;
+    }
+}
+
+void Application::printSummary() const {
+    std::cout << "\nSummary:" << std::endl;
+    std::cout << "Tests: " << m_tests.size() << ", devices: " << m_devices.size() << std::endl;
+
+    auto builds_finish = m_builds_start;
+    for (const auto& device : m_devices) { builds_finish = std::max(builds_finish, device->getLastBuildFinish()); }
+    const auto build_wall_time =
+        std::chrono::duration_cast<std::chrono::microseconds>(builds_finish - m_builds_start);
+    std::cout << "Build: " << m_build_jobs.size() << " jobs, " << build_wall_time.count() / 1000 << " ms wall time on "
+              << m_build_workers.size() << " threads" << std::endl;
+    if (m_program_cache) {
+        const auto& stats = m_program_cache->getStatistic();
+        std::cout << "Program cache: " << stats.hits << " hits, " << stats.misses << " misses, " << stats.evicted
+                  << " evicted, " << stats.size / 1024 << " KiB in " << m_settings.program_cache_dir << std::endl;
+    }
+    if (m_tuning_db) {
+        std::cout << "Tuning database: " << m_tuning_db->size() << " kernels in " << m_settings.tuning_db_path
+                  << std::endl;
+    }
+    std::cout << "Memory peak of dispatches in flight:";
+    std::vector<const MemoryBudget*> budgets = {m_host_memory.get()};
+    for (const auto& budget : m_device_memory) { budgets.push_back(budget.get()); }
+    for (const auto* budget : budgets) {
+        std::cout << (budget == budgets.front() ? " " : ", ") << budget->getName() << " " << budget->getPeak() / 1024
+                  << " KiB";
+        if (budget->getLimit() != UINTMAX_MAX) std::cout << " of " << budget->getLimit() / (1024 * 1024) << " MiB";
+    }
+    std::cout << std::endl;
+    if (m_buffer_pool) {
+        const auto stats = m_buffer_pool->getStatistic();
+        std::cout << "Buffer pool (" << m_settings.buffer_allocation << "): " << stats.requests << " requests, "
+                  << stats.allocations << " allocations of " << stats.allocated_bytes / 1024 << " KiB, "
+                  << (stats.requests ? 100.0 * stats.reused / stats.requests : 0.0) << "% reused, "
+                  << stats.sub_buffers << " sub-buffers, idle peak " << stats.peak_idle_bytes / 1024 << " KiB, "
+                  << stats.trimmed_bytes / 1024 << " KiB trimmed for memory budgets" << std::endl;
     }
-    return program;
+    for (const auto& device : m_devices) { device->printSummary(m_builds_start); }
 }
 
 }  // namespace Tester
@@ -0,0 +1,38 @@
+#include "Benchmark.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace Tester {
+
+/*static*/ TimingStatistic TimingStatistic::calculate(const std::vector<TimingSample>& samples) {
+    TimingStatistic stats;
+    if (samples.empty()) return stats;
+    std::vector<double> times;
+    double queue_to_start = 0, submit_to_start = 0;
+    for (const auto& sample : samples) {
+        times.push_back((sample.end - sample.start) / 1000.0);
+        queue_to_start += (sample.start - sample.queued) / 1000.0;
+        submit_to_start += (sample.start - sample.submit) / 1000.0;
+    }
+    std::sort(times.begin(), times.end());
+    const auto n = times.size();
+    stats.iterations = n;
+    stats.min = times.front();
+    stats.median = n % 2 ? times[n / 2] : (times[n / 2 - 1] + times[n / 2]) / 2;
+    stats.p95 = times[std::min(n - 1, static_cast<size_t>(std::ceil(0.95 * n)) - 1)];  // nearest rank
+    stats.mean = std::accumulate(times.begin(), times.end(), 0.0) / n;
+    if (n > 1) {
+        double squares = 0;
+        for (auto time : times) { squares += (time - stats.mean) * (time - stats.mean); }
+        stats.stddev = std::sqrt(squares / (n - 1));
+        stats.ci95 = 1.96 * stats.stddev / std::sqrt(static_cast<double>(n));  // normal approximation
+    }
+    stats.cv = stats.mean > 0 ? stats.stddev / stats.mean : 0;
+    stats.queue_to_start = queue_to_start / n;
+    stats.submit_to_start = submit_to_start / n;
+    return stats;
+}
+
+}  // namespace Tester
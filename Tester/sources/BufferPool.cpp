@@ -0,0 +1,98 @@
+#include "BufferPool.hpp"
+
+#include <algorithm>
+#include <bit>
+
+namespace Tester {
+
+BufferPool::BufferPool(uintmax_t idle_limit) : m_idle_limit(idle_limit) {}
+
+size_t BufferPool::getSizeClass(size_t bytes) {
+    constexpr size_t min_class = 4096;
+    if (bytes <= min_class) return min_class;
+    // 4, 5, 6, 7 quarters of the power of two below the size
+    const size_t quarter = std::bit_floor(bytes) / 4;
+    return (bytes + quarter - 1) / quarter * quarter;
+}
+
+size_t BufferPool::getAllocationSize(size_t bytes, size_t max_alloc) {
+    const size_t size_class = getSizeClass(bytes);
+    return size_class > max_alloc ? bytes : size_class;
+}
+
+size_t BufferPool::getArenaSize(const std::vector<size_t>& sizes, size_t alignment) {
+    alignment = std::max<size_t>(alignment, 1);
+    size_t total = 0;
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        total += sizes[i];
+        if (i + 1 < sizes.size()) total = (total + alignment - 1) / alignment * alignment;
+    }
+    return total;
+}
+
+cl::Buffer BufferPool::acquire(const cl::Context& context, size_t bytes, size_t max_alloc) {
+    const size_t size_class = getAllocationSize(bytes, max_alloc);
+    {
+        std::lock_guard lock(m_mutex);
+        m_statistic.requests++;
+        if (auto it = m_idle.find({context(), size_class}); it != m_idle.end() && !it->second.empty()) {
+            auto idle = std::move(it->second.back());
+            it->second.pop_back();
+            m_idle_bytes -= size_class;
+            idle.budget->releaseIdle(size_class);  // the reservation of the dispatch counts the allocation size
+            m_statistic.reused++;
+            return idle.buffer;
+        }
+    }
+    cl::Buffer buffer(context, CL_MEM_READ_WRITE, size_class);
+    std::lock_guard lock(m_mutex);
+    m_statistic.allocations++;
+    m_statistic.allocated_bytes += size_class;
+    return buffer;
+}
+
+BufferPool::Arena BufferPool::acquireArena(const cl::Context& context, const std::vector<size_t>& sizes,
+                                           size_t alignment, size_t max_alloc) {
+    alignment = std::max<size_t>(alignment, 1);
+    std::vector<cl_buffer_region> regions;
+    size_t offset = 0;
+    for (auto size : sizes) {
+        regions.push_back({offset, size});
+        offset = (offset + size + alignment - 1) / alignment * alignment;
+    }
+    Arena arena{acquire(context, getArenaSize(sizes, alignment), max_alloc), {}};
+    for (const auto& region : regions) {
+        arena.slices.push_back(arena.buffer.createSubBuffer(CL_MEM_READ_WRITE, CL_BUFFER_CREATE_TYPE_REGION, &region));
+    }
+    std::lock_guard lock(m_mutex);
+    m_statistic.sub_buffers += regions.size();
+    return arena;
+}
+
+void BufferPool::release(const cl::Context& context, cl::Buffer buffer, MemoryBudget& budget) {
+    const size_t size_class = buffer.getInfo<CL_MEM_SIZE>();
+    std::lock_guard lock(m_mutex);
+    // The buffer is released with the last reference
+    if (m_idle_bytes + size_class > m_idle_limit || !budget.tryAcquireIdle(size_class)) return;
+    m_idle[{context(), size_class}].push_back({std::move(buffer), &budget});
+    m_idle_bytes += size_class;
+    m_statistic.peak_idle_bytes = std::max(m_statistic.peak_idle_bytes, m_idle_bytes);
+}
+
+void BufferPool::trim(const cl::Context& context) {
+    std::lock_guard lock(m_mutex);
+    for (auto it = m_idle.lower_bound({context(), 0}); it != m_idle.end() && it->first.first == context();) {
+        const size_t size_class = it->first.second;
+        for (const auto& idle : it->second) { idle.budget->releaseIdle(size_class); }
+        m_idle_bytes -= size_class * it->second.size();
+        m_statistic.trimmed_bytes += size_class * it->second.size();
+        it = m_idle.erase(it);
+    }
+}
+
+BufferPool::Statistic BufferPool::getStatistic() const {
+    std::lock_guard lock(m_mutex);
+    return m_statistic;
+}
+
+}  // namespace Tester
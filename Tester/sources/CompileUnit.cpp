@@ -0,0 +1,102 @@
+#include "CompileUnit.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <regex>
+#include <set>
+#include <sstream>
+
+#include "hashpp.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+std::string readSource(const fs::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) { throw std::runtime_error("Error: Can't open opencl source!\nPath: " + path.string()); }
+    std::stringstream ss;
+    ss << file.rdbuf();
+    return ss.str();
+}
+
+std::vector<std::string> getIncludes(const std::string& source) {
+    static const std::regex include_regex(R"re(^\s*#\s*include\s*"([^"]+)")re");
+    std::vector<std::string> includes;
+    std::istringstream lines(source);
+    std::smatch match;
+    for (std::string line; std::getline(lines, line);) {
+        if (std::regex_search(line, match, include_regex)) includes.emplace_back(match[1].str());
+    }
+    return includes;
+}
+
+void collectHeaders(const fs::path& including_file, const std::string& source,
+                    const std::vector<fs::path>& include_dirs, std::vector<Tester::CompileUnit::header_type>& headers,
+                    std::set<std::string>& visited) {
+    for (auto& include_name : getIncludes(source)) {
+        if (!visited.insert(include_name).second) continue;
+
+        std::vector<fs::path> search_dirs = {including_file.parent_path()};
+        search_dirs.insert(search_dirs.end(), include_dirs.begin(), include_dirs.end());
+        auto dir = std::find_if(search_dirs.begin(), search_dirs.end(),
+                                [&](const fs::path& d) { return fs::is_regular_file(d / include_name); });
+        if (dir == search_dirs.end()) {
+            throw std::runtime_error("Error: Can't find header \"" + include_name +
+                                     "\" included from: " + including_file.string());
+        }
+        const auto header_path = *dir / include_name;
+        auto header_source = readSource(header_path);
+        collectHeaders(header_path, header_source, include_dirs, headers, visited);
+        headers.emplace_back(include_name, std::move(header_source));
+    }
+}
+}  // namespace
+
+namespace Tester {
+
+/*static*/ CompileUnit CompileUnit::load(const std::filesystem::path& path,
+                                         const std::vector<std::filesystem::path>& include_dirs) {
+    CompileUnit unit;
+    unit.name = path.filename().string();
+    if (path.extension() == ".spv") {
+        auto module = readSource(path);
+        unit.il.assign(module.begin(), module.end());
+        unit.hash = hashpp::get::getHash(hashpp::ALGORITHMS::MD5, module).getString();
+        return unit;
+    }
+    unit.source = readSource(path);
+    std::set<std::string> visited;
+    collectHeaders(path, unit.source, include_dirs, unit.headers, visited);
+    unit.updateHash();
+    return unit;
+}
+
+CompileUnit CompileUnit::specialize(const std::vector<std::pair<std::string, std::string>>& parameters) const {
+    if (parameters.empty() || !il.empty()) return *this;
+    auto substitute = [&parameters](std::string& text) {
+        for (const auto& [name, value] : parameters) {
+            const std::string placeholder = "${" + name + "}";
+            for (auto pos = text.find(placeholder); pos != std::string::npos; pos = text.find(placeholder, pos)) {
+                text.replace(pos, placeholder.size(), value);
+                pos += value.size();
+            }
+        }
+    };
+    CompileUnit unit = *this;
+    substitute(unit.source);
+    for (auto& header : unit.headers) { substitute(header.second); }
+    unit.updateHash();
+    return unit;
+}
+
+void CompileUnit::updateHash() {
+    std::string data = source;
+    auto sorted_headers = headers;
+    std::sort(sorted_headers.begin(), sorted_headers.end());
+    for (const auto& [name, header_source] : sorted_headers) {
+        data.append(1, '\0').append(name).append(1, '\0').append(header_source);
+    }
+    hash = hashpp::get::getHash(hashpp::ALGORITHMS::MD5, data).getString();
+}
+
+}  // namespace Tester
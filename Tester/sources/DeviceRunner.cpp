@@ -0,0 +1,1475 @@
+#include "DeviceRunner.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+
+namespace {
+const cl::QueueProperties getQueueProperties() noexcept {
+    return cl::QueueProperties::Profiling | cl::QueueProperties::OutOfOrder;
+}
+
+std::optional<Tester::Test::GPUVenderType> getVendor(const std::string& vendor) {
+    auto end_npos = std::string::npos;
+    if (vendor.find("NVIDIA") != end_npos || vendor.find("nvidia") != end_npos) {
+        return Tester::Test::GPUVenderType::NVIDIA;
+    }
+    if (vendor.find("AMD") != end_npos || vendor.find("amd") != end_npos ||
+        vendor.find("Advanced Micro Devices") != end_npos) {
+        return Tester::Test::GPUVenderType::AMD;
+    }
+    if (vendor.find("INTEL") != end_npos || vendor.find("intel") != end_npos) {
+        return Tester::Test::GPUVenderType::INTEL;
+    }
+    return std::nullopt;
+}
+std::runtime_error getBuildError(const cl::Program& program, std::string_view what) {
+    std::stringstream ss;
+    ss << "\ncompileProgram(..) error: \n";
+    ss << "Exception: \"" << what << "\"" << std::endl;
+    ss << "Reason:\n";
+    auto buildInfo = program.getBuildInfo<CL_PROGRAM_BUILD_LOG>();
+    for (auto& [device, error] : buildInfo) {
+        ss << "Program build log for device \"" << device.getInfo<CL_DEVICE_NAME>()
+           << "\"\nwith compiler arguments: \"" << program.getBuildInfo<CL_PROGRAM_BUILD_OPTIONS>(device)
+           << "\"\nKernal: " << program.getInfo<CL_PROGRAM_SOURCE>() << std::endl
+           << "Compilation error: \n"
+           << error << std::endl;
+    }
+    return std::runtime_error(ss.str());
+}
+
+std::vector<unsigned char> getDeviceBinary(const cl::Program& program, const cl::Device& device) {
+    const auto devices = program.getInfo<CL_PROGRAM_DEVICES>();
+    auto binaries = program.getInfo<CL_PROGRAM_BINARIES>();
+    for (size_t i = 0; i < devices.size() && i < binaries.size(); ++i) {
+        if (devices[i]() == device()) return std::move(binaries[i]);
+    }
+    return {};
+}
+
+// Identifies everything that goes into the program, headers and libraries included
+std::string getProgramId(const Tester::Test& test, const Tester::CompileUnit& program) {
+    std::string id = "program:" + program.hash;
+    for (const auto& library : test.getLibraries()) { id += ":" + library.hash; }
+    return id;
+}
+
+// clLinkProgram accepts only a few math options, the rest are compile options
+std::string getLinkOptions(const std::string& options) {
+    static const std::set<std::string> link_options = {
+        "-cl-denorms-are-zero",  "-cl-no-signed-zeros",   "-cl-unsafe-math-optimizations",
+        "-cl-finite-math-only",  "-cl-fast-relaxed-math", "-cl-no-subgroup-ifp"};
+    std::istringstream ss(options);
+    std::string result;
+    for (std::string option; ss >> option;) {
+        if (link_options.contains(option)) result += (result.empty() ? "" : " ") + option;
+    }
+    return result;
+}
+
+bool isInPlaceInput(const Tester::Test& test, size_t input) {
+    const auto& outputs = test.getOutputs();
+    return std::any_of(outputs.begin(), outputs.end(), [&](const auto& output) { return output.in_place == input; });
+}
+
+// An in-place kernel changes its inputs, it can't be dispatched again on the same buffers
+bool hasInPlaceOutputs(const Tester::Test& test) {
+    const auto& outputs = test.getOutputs();
+    return std::any_of(outputs.begin(), outputs.end(), [](const auto& output) { return output.in_place.has_value(); });
+}
+
+// Event that completes with every event of the list
+cl::Event getCompletion(cl::CommandQueue& queue, const std::vector<cl::Event>& events) {
+    if (events.size() == 1) return events.front();
+    cl::Event marker;
+    queue.enqueueMarkerWithWaitList(&events, &marker);
+    return marker;
+}
+
+// Binds the "Arguments" of the test to buffers or SVM pointers, an in-place output is its input
+template<typename Memory>
+void setArguments(cl::Kernel& kernel, const Tester::Test& test, const Tester::Test::Variant& variant,
+                  const std::vector<Memory>& inputs, const std::vector<Memory>& outputs) {
+    using Kind = Tester::Test::Argument::Kind;
+    const auto& arguments = test.getArguments();
+    for (cl_uint i = 0; i < arguments.size(); ++i) {
+        const auto& argument = arguments[i];
+        switch (argument.kind) {
+            case Kind::input: kernel.setArg(i, inputs.at(argument.index)); break;
+            case Kind::output: kernel.setArg(i, outputs.at(argument.index)); break;
+            case Kind::scalar: {
+                const auto bytes = Tester::Test::getScalar(argument, variant.specialization);
+                kernel.setArg(i, bytes.size(), bytes.data());
+                break;
+            }
+            case Kind::local:
+                kernel.setArg(i, cl::Local(Tester::Test::getLocalSize(argument, variant.specialization)));
+                break;
+        }
+    }
+}
+
+// clSVMAlloc allocation of a context
+struct SvmDeleter {
+    cl_context context;
+    void operator()(uint8_t* pointer) const { clSVMFree(context, pointer); }
+};
+using SvmPointer = std::unique_ptr<uint8_t, SvmDeleter>;
+
+double getDuration(const cl::Event& event) {  // in s
+    return (event.getProfilingInfo<CL_PROFILING_COMMAND_END>() - event.getProfilingInfo<CL_PROFILING_COMMAND_START>()) /
+           1000.0;
+}
+
+cl::NDRange toNDRange(const std::vector<size_t>& sizes) {
+    switch (sizes.size()) {
+        case 1: return cl::NDRange(sizes[0]);
+        case 2: return cl::NDRange(sizes[0], sizes[1]);
+        case 3: return cl::NDRange(sizes[0], sizes[1], sizes[2]);
+        default: return cl::NullRange;
+    }
+}
+
+std::string toString(const std::vector<size_t>& sizes) {
+    if (sizes.empty()) return "auto";
+    std::string result;
+    for (auto size : sizes) { result += (result.empty() ? "" : "x") + std::to_string(size); }
+    return result;
+}
+
+// The best local size depends on the kernel, its build options, the global size and the device
+std::string getTuningKey(const Tester::CompiledProgram& compiled, const Tester::Test& test,
+                         const Tester::Test::Variant& variant, const std::vector<size_t>& global,
+                         const cl::Device& device) {
+    return Tester::ProgramCache::makeKey(compiled.id + ":" + test.getName() + ":" + toString(global), variant.options,
+                                         device);
+}
+}  // namespace
+
+namespace Tester {
+DeviceRunner::DeviceRunner(cl::Device device, std::string label, const Settings& settings,
+                           ProgramCache* program_cache, TuningDatabase* tuning_db, MemoryBudget& device_memory,
+                           MemoryBudget& host_memory, BufferPool* buffer_pool)
+    : m_settings(settings), m_label(std::move(label)), m_device(std::move(device)), m_context(m_device),
+      m_queue(m_context, m_device, getQueueProperties()), m_program_cache(program_cache), m_tuning_db(tuning_db),
+      m_device_memory(device_memory), m_host_memory(host_memory), m_buffer_pool(buffer_pool) {
+    const cl::Platform platform(m_device.getInfo<CL_DEVICE_PLATFORM>());
+    const auto name = platform.getInfo<CL_PLATFORM_NAME>();
+    const auto profile = platform.getInfo<CL_PLATFORM_PROFILE>();
+    const auto version = platform.getInfo<CL_PLATFORM_VERSION>();
+    const auto vendor = platform.getInfo<CL_PLATFORM_VENDOR>();
+    std::vector<cl_name_version> extentions;
+    try {
+        extentions = platform.getInfo<CL_PLATFORM_EXTENSIONS_WITH_VERSION>();
+    } catch (const std::exception& e) { std::cerr << "OpenCL get extentions error: " << e.what() << std::endl; }
+
+    m_vendor = getVendor(vendor);
+    m_type = m_device.getInfo<CL_DEVICE_TYPE>();
+    m_compute_units = m_device.getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>();
+    m_base_addr_align = std::max<size_t>(m_device.getInfo<CL_DEVICE_MEM_BASE_ADDR_ALIGN>() / 8, 1);  // in bits
+    m_max_alloc = m_device.getInfo<CL_DEVICE_MAX_MEM_ALLOC_SIZE>();
+    if (m_settings.zero_copy == "auto") {
+        try {
+            m_zero_copy = m_device.getInfo<CL_DEVICE_HOST_UNIFIED_MEMORY>();
+        } catch (const std::exception&) { m_zero_copy = false; }  // deprecated query
+    } else {
+        m_zero_copy = m_settings.zero_copy == "on";
+    }
+    // Nothing is uploaded in zero-copy mode
+    if (m_settings.input_cache_size && !m_zero_copy) {
+        m_input_cache = std::make_unique<InputCache>(m_settings.input_cache_size, m_device_memory);
+    }
+    std::cout << m_label << ": " << getName() << "\nPlatform: " << name << "\nVersion: " << version
+              << ", Profile: " << profile << "\nVendor:  " << vendor << "\nType: " << getTypeName(m_type) << ", "
+              << m_compute_units << " compute units, " << m_device.getInfo<CL_DEVICE_MAX_CLOCK_FREQUENCY>() << " MHz"
+              << std::endl;
+
+    for (const auto& ext : extentions) {
+        if (std::string(ext.name) == "cl_khr_fp16") std::cout << "Supported fp16 extention" << std::endl;
+    }
+    try {
+        m_il_supported = m_device.getInfo<CL_DEVICE_IL_VERSION>().find("SPIR-V") != std::string::npos;
+    } catch (const std::exception&) { m_il_supported = false; }
+    if (m_il_supported) std::cout << "Supported SPIR-V programs" << std::endl;
+    if (m_zero_copy) {
+        // Pooled buffers may live in device memory, zero-copy allocates host-accessible ones
+        std::cout << "Zero-copy buffers";
+        if (m_buffer_pool) std::cout << ", buffer allocation \"" << m_settings.buffer_allocation << "\" is overridden";
+        std::cout << std::endl;
+    }
+    try {
+        m_svm_capabilities = m_device.getInfo<CL_DEVICE_SVM_CAPABILITIES>();
+    } catch (const std::exception&) { m_svm_capabilities = 0; }
+    if (m_svm_capabilities & CL_DEVICE_SVM_FINE_GRAIN_BUFFER) {
+        std::cout << "Supported coarse- and fine-grained SVM buffers" << std::endl;
+    } else if (m_svm_capabilities & CL_DEVICE_SVM_COARSE_GRAIN_BUFFER) {
+        std::cout << "Supported coarse-grained SVM buffers" << std::endl;
+    }
+    std::cout << std::endl;
+
+    // The out-of-order queue overlaps the commands of one pipeline, in-order queues overlap independent tests
+    for (unsigned int i = 0; i < m_settings.queue_count; ++i) {
+        m_queues.emplace_back(m_context, m_device, cl::QueueProperties::Profiling);
+    }
+    if (m_queues.empty()) m_queues.push_back(m_queue);
+
+    // Any runner that shares the device budget drops the idle buffers of this context when it needs the memory.
+    // Added last, a runner that fails to construct leaves nothing in the budget
+    if (m_buffer_pool) {
+        m_device_memory.addReclaimer([this] { m_buffer_pool->trim(m_context); });
+    }
+    if (m_input_cache) {
+        m_device_memory.addReclaimer([this] { m_input_cache->clear(); });
+    }
+}
+
+/*static*/ std::string DeviceRunner::getTypeName(cl_device_type type) {
+    if (type & CL_DEVICE_TYPE_GPU) return "GPU";
+    if (type & CL_DEVICE_TYPE_CPU) return "CPU";
+    if (type & CL_DEVICE_TYPE_ACCELERATOR) return "ACC";
+    return "DEV";
+}
+
+bool DeviceRunner::isSupported(const Test& test) const noexcept {
+    if (test.isIL() && !m_il_supported) return false;
+    // Tests without a vendor run on every device
+    return !test.getVenderType().has_value() || test.getVenderType() == m_vendor;
+}
+
+void DeviceRunner::prepare(const std::vector<Test>& tests, const std::vector<std::vector<Test::Variant>>& variants,
+                           TestScheduler& scheduler, size_t worker) {
+    m_tests = &tests;
+    m_variants = &variants;
+    m_scheduler = &scheduler;
+    m_worker = worker;
+    m_build_promises.clear();
+    m_builds.clear();
+    m_result_promises = std::vector<std::promise<TestResult>>(tests.size());
+    m_results.clear();
+    for (size_t test_id = 0; test_id < tests.size(); ++test_id) {
+        m_build_promises.emplace_back(variants[test_id].size());
+        m_builds.emplace_back();
+        for (auto& promise : m_build_promises.back()) { m_builds.back().emplace_back(promise.get_future().share()); }
+        m_results.emplace_back(m_result_promises[test_id].get_future().share());
+    }
+}
+
+void DeviceRunner::build(size_t test_id, size_t variant_id) {
+    const auto& test = (*m_tests)[test_id];
+    if (!isSupported(test)) return;
+    auto& promise = m_build_promises[test_id][variant_id];
+    try {
+        promise.set_value(compileProgram(test, (*m_variants)[test_id][variant_id]));
+    } catch (...) { promise.set_exception(std::current_exception()); }
+}
+
+const TestResult& DeviceRunner::getResult(size_t test_id) const {
+    return m_results.at(test_id).get();
+}
+
+std::vector<size_t> DeviceRunner::getGlobalSize(const Test& test, const Test::Variant& variant,
+                                               size_t output_elements) const {
+    auto global = test.getNDRange().global;
+    if (global.empty()) {
+        const auto items_per_work_item = variant.specialization.items_per_work_item;
+        if (output_elements % items_per_work_item != 0) {
+            throw std::runtime_error("Output size isn't divisible by " + std::to_string(items_per_work_item) +
+                                     " items per work-item");
+        }
+        global = {output_elements / items_per_work_item};
+    }
+    const auto max_dimensions = m_device.getInfo<CL_DEVICE_MAX_WORK_ITEM_DIMENSIONS>();
+    if (global.size() > max_dimensions) {
+        throw std::runtime_error("NDRange has " + std::to_string(global.size()) + " dimensions, device supports " +
+                                 std::to_string(max_dimensions));
+    }
+    return global;
+}
+
+void DeviceRunner::checkLocalSize(const cl::Kernel& kernel, const std::vector<size_t>& global,
+                                 const std::vector<size_t>& local) const {
+    if (local.empty()) return;
+    const auto max_work_item_sizes = m_device.getInfo<CL_DEVICE_MAX_WORK_ITEM_SIZES>();
+    const auto max_work_group_size = kernel.getWorkGroupInfo<CL_KERNEL_WORK_GROUP_SIZE>(m_device);
+    size_t work_group_size = 1;
+    for (size_t i = 0; i < local.size(); i++) {
+        if (local[i] > max_work_item_sizes[i]) {
+            throw std::runtime_error("LocalSize[" + std::to_string(i) + "] = " + std::to_string(local[i]) +
+                                     " exceeds CL_DEVICE_MAX_WORK_ITEM_SIZES " + std::to_string(max_work_item_sizes[i]));
+        }
+        if (global[i] % local[i] != 0 && !m_device.getInfo<CL_DEVICE_NON_UNIFORM_WORK_GROUP_SUPPORT>()) {
+            throw std::runtime_error("GlobalSize[" + std::to_string(i) + "] isn't divisible by LocalSize[" +
+                                     std::to_string(i) + "] and device has no non-uniform work-groups");
+        }
+        work_group_size *= local[i];
+    }
+    if (work_group_size > max_work_group_size) {
+        throw std::runtime_error("Work-group size " + std::to_string(work_group_size) +
+                                 " exceeds CL_KERNEL_WORK_GROUP_SIZE " + std::to_string(max_work_group_size));
+    }
+}
+
+std::vector<std::vector<size_t>> DeviceRunner::getLocalSizeCandidates(const cl::Kernel& kernel,
+                                                                     const std::vector<size_t>& global) const {
+    const size_t multiple =
+        std::max<size_t>(kernel.getWorkGroupInfo<CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE>(m_device), 1);
+    const auto max_work_group_size = kernel.getWorkGroupInfo<CL_KERNEL_WORK_GROUP_SIZE>(m_device);
+    std::vector<std::vector<size_t>> candidates = {{}};  // "auto" is the baseline
+    if (global.size() == 1) {
+        for (size_t size = multiple; size <= max_work_group_size; size *= 2) { candidates.push_back({size}); }
+    } else {
+        // Power of two tiles of the first two dimensions, higher dimensions aren't tiled
+        for (size_t x = 1; x <= max_work_group_size; x *= 2) {
+            for (size_t y = 1; x * y <= max_work_group_size; y *= 2) {
+                if ((x * y) % multiple != 0) continue;
+                std::vector<size_t> local(global.size(), 1);
+                local[0] = x;
+                local[1] = y;
+                candidates.push_back(std::move(local));
+            }
+        }
+    }
+    std::erase_if(candidates, [&](const std::vector<size_t>& local) {
+        try {
+            checkLocalSize(kernel, global, local);
+            return false;
+        } catch (const std::exception&) { return true; }
+    });
+    return candidates;
+}
+
+std::optional<TuningDatabase::Entry> DeviceRunner::autotune(const Test& test, const cl::Kernel& kernel,
+                                                           const std::vector<size_t>& global,
+                                                           const std::vector<cl::Buffer>& outputs,
+                                                           std::ostream& log) {
+    constexpr size_t runs = 3;  // the fastest of a few runs, a single one is too noisy to rank candidates
+    const auto& buffers = test.getOutputs();
+    const auto offset = toNDRange(test.getNDRange().offset);
+
+    std::optional<TuningDatabase::Entry> best;
+    std::optional<double> auto_time;
+    size_t failed = 0;
+    const auto candidates = getLocalSizeCandidates(kernel, global);
+    for (const auto& local : candidates) {
+        double time_us = std::numeric_limits<double>::max();
+        try {
+            for (size_t run = 0; run < runs; ++run) {
+                cl::Event evt;
+                m_queue.enqueueNDRangeKernel(kernel, offset, toNDRange(global), toNDRange(local), nullptr, &evt);
+                evt.wait();
+                const auto start = evt.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+                time_us = std::min(time_us, (evt.getProfilingInfo<CL_PROFILING_COMMAND_END>() - start) / 1000.0);
+            }
+            bool matches = true;
+            for (size_t i = 0; i < buffers.size(); ++i) {
+                const auto& [golden_name, golden_type, golden] = buffers[i].goldens.front().second;
+                std::vector<uint8_t> result(golden.size());
+                cl::copy(m_queue, outputs[i], result.begin(), result.end());
+                matches = matches && Test::matchesGolden(golden_type, golden, result);
+            }
+            if (!matches) {
+                failed++;
+                continue;
+            }
+        } catch (const std::exception&) {
+            failed++;
+            continue;
+        }
+        if (local.empty()) auto_time = time_us;
+        if (!best.has_value() || time_us < best->kernel_time_us) {
+            best = TuningDatabase::Entry{local, time_us, test.getName(), m_device.getInfo<CL_DEVICE_NAME>()};
+        }
+    }
+
+    log << "Autotune: " << test.getName() << ", global size " << toString(global) << ", "
+        << candidates.size() << " local sizes, " << failed << " failed or wrong" << std::endl;
+    if (best.has_value()) {
+        log << "Best local size: " << toString(best->local_size) << ", " << best->kernel_time_us
+            << " Microseconds";
+        if (auto_time.has_value()) log << " (auto: " << *auto_time << " Microseconds)";
+        log << std::endl;
+    }
+    return best;
+}
+
+std::optional<DeviceRunner::Dispatch> DeviceRunner::enqueueDispatch(const Test& test, const Test::Variant& variant,
+                                                                   const CompiledProgram& compiled,
+                                                                   cl::CommandQueue& queue, std::ostream& log) {
+    Dispatch dispatch;
+    auto& kernel = dispatch.kernel;
+    try {
+        kernel = cl::Kernel(compiled.program, test.getName().c_str());
+    } catch (const std::exception& e) {
+        log << "Error during kernel creation! Test: " << test.getName() << "\nError : " << e.what() << std::endl;
+        return std::nullopt;
+    }
+
+    auto& output_info = test.getOutputs();
+    if (output_info.empty()) {
+        log << "Warning: output blobs for test: \"" << test.getName() << "\" are empty !" << std::endl;
+        return std::nullopt;
+    }
+    std::optional<size_t> chunk_elements;
+    try {
+        chunk_elements = getChunkElements(test);
+        if (chunk_elements.has_value()) enqueueChunks(test, variant, *chunk_elements, queue, dispatch);
+    } catch (const std::exception& e) {
+        log << "Error during chunked dispatch! Test: " << test.getName() << "\nError : " << e.what() << std::endl;
+        return std::nullopt;
+    }
+    if (chunk_elements.has_value()) return dispatch;
+    auto& input_info = test.getInputs();
+    // Read-only inputs go through the input cache, a resident one is bound without an upload
+    auto isCached = [&](size_t input) { return m_input_cache && !isInPlaceInput(test, input); };
+    std::vector<bool> resident(input_info.size(), false);
+    std::vector<bool> wrapped(input_info.size(), false);  // zero-copy: the kernel reads the blob of the test
+    try {
+        dispatch.inputs.resize(input_info.size());
+        // Pooled buffers: inputs that aren't cached and then the outputs that aren't in place
+        std::vector<std::pair<size_t, cl_mem_flags>> requests;
+        std::vector<size_t> requested_inputs;
+        for (size_t i = 0; i < input_info.size(); ++i) {
+            const auto& blob = std::get<2>(input_info[i]);
+            const size_t size = blob.size();
+            if (m_zero_copy && !isInPlaceInput(test, i)) {
+                // Variants in flight share the buffer, buffers over overlapping host memory are undefined
+                auto it = m_wrapped_inputs.find(blob.data());
+                if (it == m_wrapped_inputs.end()) {
+                    cl::Buffer buffer(m_context, CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR, size,
+                                      const_cast<uint8_t*>(blob.data()));
+                    it = m_wrapped_inputs.emplace(blob.data(), std::move(buffer)).first;
+                }
+                dispatch.inputs[i] = it->second;
+                wrapped[i] = true;
+            } else if (!isCached(i)) {
+                requests.emplace_back(size, isInPlaceInput(test, i) ? CL_MEM_READ_WRITE : CL_MEM_READ_ONLY);
+                requested_inputs.push_back(i);
+            } else if (auto entry = m_input_cache->find(test.getInputHash(i)); entry.has_value()) {
+                dispatch.inputs[i] = entry->buffer;
+                dispatch.resident_events.push_back(entry->upload);
+                dispatch.resident_pins.push_back(std::move(entry->pin));
+                dispatch.resident_bytes += size;
+                resident[i] = true;
+            } else {
+                dispatch.inputs[i] = cl::Buffer(m_context, CL_MEM_READ_ONLY, size);  // outlives the dispatch
+            }
+        }
+        for (const auto& output : output_info) {
+            dispatch.host_outputs.emplace_back(output.getSize());
+            if (!output.in_place.has_value() && !m_zero_copy) {
+                requests.emplace_back(output.getSize(), CL_MEM_WRITE_ONLY);
+            }
+        }
+        auto buffers = allocateBuffers(requests, dispatch);
+        for (size_t i = 0; i < requested_inputs.size(); ++i) { dispatch.inputs[requested_inputs[i]] = buffers[i]; }
+        for (size_t i = 0, next = requested_inputs.size(); i < output_info.size(); ++i) {
+            auto& host = dispatch.host_outputs[i];
+            if (output_info[i].in_place.has_value()) {
+                dispatch.outputs.push_back(dispatch.inputs[*output_info[i].in_place]);
+            } else if (m_zero_copy) {
+                // The readback maps the buffer at the host memory of the result, nothing is copied
+                dispatch.outputs.emplace_back(m_context, CL_MEM_WRITE_ONLY | CL_MEM_USE_HOST_PTR, host.size(),
+                                              host.data());
+            } else {
+                dispatch.outputs.push_back(buffers[next++]);
+            }
+        }
+        setArguments(kernel, test, variant, dispatch.inputs, dispatch.outputs);
+    } catch (const std::exception& e) {
+        log << "Error during buffer allocation! Test: " << test.getName() << "\nError : " << e.what() << std::endl;
+        return std::nullopt;
+    }
+    try {
+        for (size_t i = 0; i < input_info.size(); ++i) {
+            auto& buffer = std::get<2>(input_info[i]);
+            if (resident[i] || wrapped[i]) {
+                (wrapped[i] ? m_wrapped_bytes : m_resident_bytes) += buffer.size();
+                continue;
+            }
+            dispatch.upload_events.emplace_back();
+            queue.enqueueWriteBuffer(dispatch.inputs[i], CL_FALSE, 0, buffer.size(), buffer.data(), nullptr,
+                                     &dispatch.upload_events.back());
+            m_uploaded_bytes += buffer.size();
+            if (isCached(i)) dispatch.cache_misses.emplace_back(i, dispatch.upload_events.back());
+        }
+    } catch (const std::exception& e) {
+        log << "Error during upload! Test: " << test.getName() << "\nError : " << e.what() << std::endl;
+        return std::nullopt;
+    }
+    auto kernel_wait = dispatch.upload_events;
+    kernel_wait.insert(kernel_wait.end(), dispatch.resident_events.begin(), dispatch.resident_events.end());
+    // "auto" global size follows the first output buffer
+    const auto output_size = output_info[0].getSize();
+    const auto output_type = output_info[0].getType();
+
+    auto& local = dispatch.local = test.getNDRange().local;
+    try {
+        dispatch.global = getGlobalSize(test, variant, output_size / Test::getTypeSize(output_type));
+        if (local.empty() && m_tuning_db) {
+            // Explicit LocalSize of the test always wins over the tuning database
+            const auto tuning_key = getTuningKey(compiled, test, variant, dispatch.global, m_device);
+            const bool tune = m_settings.autotune && !hasInPlaceOutputs(test);
+            if (tune && !kernel_wait.empty()) cl::Event::waitForEvents(kernel_wait);
+            auto entry = tune ? autotune(test, kernel, dispatch.global, dispatch.outputs, log)
+                              : m_tuning_db->find(tuning_key);
+            if (entry.has_value()) {
+                if (tune) m_tuning_db->update(tuning_key, *entry);
+                local = entry->local_size;
+                dispatch.tuned = true;
+            }
+        }
+        checkLocalSize(kernel, dispatch.global, local);
+    } catch (const std::exception& e) {
+        log << "Warning: " << e.what() << "\nTest: \"" << test.getName() << "\" " << variant.name << " on "
+            << m_label << " is skipped" << std::endl;
+        return std::nullopt;
+    }
+
+    // upload -> kernel -> readback are chained by events, nothing blocks the host until finishDispatch
+    try {
+        queue.enqueueNDRangeKernel(kernel, toNDRange(test.getNDRange().offset), toNDRange(dispatch.global),
+                                   toNDRange(local), &kernel_wait, &dispatch.kernel_event);
+        const std::vector<cl::Event> kernel_done = {dispatch.kernel_event};
+        for (size_t i = 0; i < output_info.size(); ++i) {
+            dispatch.read_events.emplace_back();
+            if (m_zero_copy) {
+                dispatch.mapped.push_back(queue.enqueueMapBuffer(dispatch.outputs[i], CL_FALSE, CL_MAP_READ, 0,
+                                                                 dispatch.host_outputs[i].size(), &kernel_done,
+                                                                 &dispatch.read_events.back()));
+                continue;
+            }
+            queue.enqueueReadBuffer(dispatch.outputs[i], CL_FALSE, 0, dispatch.host_outputs[i].size(),
+                                    dispatch.host_outputs[i].data(), &kernel_done, &dispatch.read_events.back());
+        }
+        dispatch.read_event = getCompletion(queue, dispatch.read_events);
+        queue.flush();
+    } catch (const std::exception& e) {
+        log << "Error during dispatch! Test: " << test.getName() << "\nError : " << e.what() << std::endl;
+        return std::nullopt;
+    }
+    return dispatch;
+}
+
+DispatchResult DeviceRunner::finishDispatch(const Test& test, const Test::Variant& variant,
+                                            const CompiledProgram& compiled, Dispatch& dispatch, std::ostream& log) {
+    try {
+        dispatch.read_event.wait();
+    } catch (const std::exception& e) {
+        log << "Error during dispatch! Test: " << test.getName() << "\nError : " << e.what() << std::endl;
+        return {};
+    }
+    // Mapped outputs are unmapped before benchmark dispatches write them again. A wrapped output is mapped at the
+    // host memory of the result, an in-place one is copied out: the benchmark updates it again
+    std::vector<cl::Event> unmap_events(dispatch.mapped.size());
+    for (size_t i = 0; i < dispatch.mapped.size(); ++i) {
+        const auto* mapped = static_cast<const uint8_t*>(dispatch.mapped[i]);
+        auto& host = dispatch.host_outputs[i];
+        if (mapped != host.data()) std::copy(mapped, mapped + host.size(), host.begin());
+        m_queue.enqueueUnmapMemObject(dispatch.outputs[i], dispatch.mapped[i], nullptr, &unmap_events[i]);
+    }
+    if (!unmap_events.empty()) cl::Event::waitForEvents(unmap_events);
+    const bool wrapped_outputs = !dispatch.mapped.empty();
+    dispatch.mapped.clear();
+    DispatchResult result;
+    result.outputs = std::move(dispatch.host_outputs);
+
+    // A chunked dispatch takes the sum of its kernels
+    auto kernel_events = dispatch.chunk_kernel_events;
+    if (kernel_events.empty()) kernel_events.push_back(dispatch.kernel_event);
+    cl_ulong kernel_time = 0;  // in ns
+    for (const auto& evt : kernel_events) {
+        kernel_time +=
+            evt.getProfilingInfo<CL_PROFILING_COMMAND_END>() - evt.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+    }
+    auto GDur = kernel_time / 1000;  // ns -> s
+    result.kernel_time_us = kernel_time / 1000.0;
+
+    auto addInterval = [this](const cl::Event& command) {
+        m_device_intervals.emplace_back(command.getProfilingInfo<CL_PROFILING_COMMAND_START>(),
+                                        command.getProfilingInfo<CL_PROFILING_COMMAND_END>());
+    };
+    for (const auto& upload : dispatch.upload_events) { addInterval(upload); }
+    if (dispatch.chunk_kernel_events.empty()) addInterval(dispatch.kernel_event);
+    for (const auto& kernel : dispatch.chunk_kernel_events) { addInterval(kernel); }
+    for (const auto& read : dispatch.read_events) { addInterval(read); }
+
+    log << "\nTest: " << test.getName() << " on " << m_label << " (" << getName() << ")" << std::endl;
+    if (!variant.options.empty()) {
+        log << "Variant " << variant.name << (variant.name.empty() ? "" : ", ") << "build options: " << variant.options
+            << std::endl;
+    }
+    log << "Global size: " << toString(dispatch.global) << ", local size: " << toString(dispatch.local)
+        << (dispatch.tuned ? " (tuned)" : "") << std::endl;
+    if (!dispatch.chunk_kernel_events.empty()) {
+        log << "Chunks: " << dispatch.chunk_kernel_events.size() << ", double-buffered" << std::endl;
+    }
+    log << "Build time: " << compiled.build_time.count() << " Microseconds";
+    if (compiled.from_cache) {
+        log << " (program cache)" << std::endl;
+    } else {
+        log << " (front-end: " << compiled.frontend_time.count()
+            << ", back-end: " << compiled.backend_time.count() << ")" << std::endl;
+    }
+    log << m_label << ": Vertex shader pure time measured: " << GDur << " Microseconds"
+        << formatCorrectedTime(result.kernel_time_us) << std::endl;
+
+    if (m_settings.benchmark && !dispatch.chunk_kernel_events.empty()) {
+        log << "Benchmark is skipped: chunked dispatch" << std::endl;
+    } else if (m_settings.benchmark) {
+        try {
+            const auto& stats =
+                result.timing.emplace(benchmark(dispatch.kernel, toNDRange(test.getNDRange().offset),
+                                                toNDRange(dispatch.global), toNDRange(dispatch.local)));
+            result.kernel_time_us = stats.median;
+            log << "Benchmark: " << stats.iterations << " iterations after " << m_settings.warmup_iterations
+                << " warmup, Microseconds: min " << stats.min << ", median " << stats.median << ", mean "
+                << stats.mean << " +- " << stats.ci95 << ", p95 " << stats.p95 << ", stddev " << stats.stddev
+                << ", CV " << stats.cv * 100 << "%" << std::endl;
+            log << "Benchmark median: " << stats.median << " Microseconds" << formatCorrectedTime(stats.median)
+                << std::endl;
+            log << "Launch latency, Microseconds: queued -> start " << stats.queue_to_start
+                << ", submit -> start " << stats.submit_to_start << std::endl;
+            if (m_settings.benchmark_iterations == 0 && stats.ci95 > m_settings.benchmark_precision * stats.mean) {
+                log << "Warning: confidence interval isn't within " << m_settings.benchmark_precision * 100
+                    << "% of the mean after " << stats.iterations << " iterations" << std::endl;
+            }
+        } catch (const std::exception& e) {
+            log << "Error during benchmark! Test: " << test.getName() << "\nError : " << e.what() << std::endl;
+        }
+        // The benchmark dispatches wrote the wrapped outputs again, a mapping makes the host memory valid
+        for (size_t i = 0; wrapped_outputs && i < result.outputs.size(); ++i) {
+            if (test.getOutputs()[i].in_place.has_value()) continue;
+            try {
+                cl::Event unmap_event;
+                auto* mapped = m_queue.enqueueMapBuffer(dispatch.outputs[i], CL_TRUE, CL_MAP_READ, 0,
+                                                        result.outputs[i].size());
+                m_queue.enqueueUnmapMemObject(dispatch.outputs[i], mapped, nullptr, &unmap_event);
+                unmap_event.wait();
+            } catch (const std::exception& e) {
+                log << "Error during readback! Test: " << test.getName() << "\nError : " << e.what() << std::endl;
+                result.outputs.clear();
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+void DeviceRunner::compareSvm(const Test& test, const Test::Variant& variant, Dispatch& dispatch,
+                              const DispatchResult& result, std::ostream& log) {
+    if (result.outputs.empty()) return;
+    // A fine-grained device supports coarse-grained buffers too
+    const bool fine_grain = m_svm_capabilities & CL_DEVICE_SVM_FINE_GRAIN_BUFFER;
+    if (!fine_grain && !(m_svm_capabilities & CL_DEVICE_SVM_COARSE_GRAIN_BUFFER)) return;
+    // Nothing else is in flight (the pipeline depth is 0), the runner may block on the budgets
+    const uintmax_t device_bytes = test.getFootprint();
+    const uintmax_t host_bytes = getHostFootprint(test);
+    for (const bool fine : {false, true}) {
+        if (fine && !fine_grain) continue;
+        m_device_memory.acquire(device_bytes);
+        m_host_memory.acquire(host_bytes);
+        try {
+            runSvm(test, variant, dispatch, result, fine, log);
+        } catch (const std::exception& e) {
+            log << "Error during SVM dispatch! Test: " << test.getName() << "\nError : " << e.what() << std::endl;
+        }
+        m_device_memory.release(device_bytes);
+        m_host_memory.release(host_bytes);
+    }
+}
+
+void DeviceRunner::runSvm(const Test& test, const Test::Variant& variant, Dispatch& dispatch,
+                          const DispatchResult& result, bool fine_grain, std::ostream& log) {
+    const auto& input_info = test.getInputs();
+    const auto& output_info = test.getOutputs();
+    std::vector<SvmPointer> allocations;
+    auto allocate = [&](size_t size) {
+        const cl_svm_mem_flags flags = CL_MEM_READ_WRITE | (fine_grain ? CL_MEM_SVM_FINE_GRAIN_BUFFER : 0);
+        auto* pointer = static_cast<uint8_t*>(clSVMAlloc(m_context(), flags, size, 0));
+        if (pointer == nullptr) throw std::runtime_error("clSVMAlloc of " + std::to_string(size) + " bytes failed");
+        allocations.emplace_back(pointer, SvmDeleter{m_context()});
+        return pointer;
+    };
+
+    // Fine-grained memory is written and read by the host directly, coarse-grained is copied by the queue
+    double transfer_time = 0;
+    std::vector<cl::Event> copies;
+    auto transfer = [&](uint8_t* dst, const uint8_t* src, size_t size) {
+        if (fine_grain) {
+            const auto start = std::chrono::steady_clock::now();
+            std::copy(src, src + size, dst);
+            const std::chrono::duration<double, std::micro> copy_time = std::chrono::steady_clock::now() - start;
+            transfer_time += copy_time.count();
+            return;
+        }
+        copies.emplace_back();
+        m_queue.enqueueMemcpySVM(dst, src, CL_FALSE, size, nullptr, &copies.back());
+    };
+    auto finishTransfers = [&]() {
+        if (copies.empty()) return;
+        cl::Event::waitForEvents(copies);
+        for (const auto& copy : copies) { transfer_time += getDuration(copy); }
+        copies.clear();
+    };
+
+    std::vector<uint8_t*> inputs, outputs;
+    for (const auto& input : input_info) {
+        const auto& blob = std::get<2>(input);
+        inputs.push_back(allocate(blob.size()));
+        transfer(inputs.back(), blob.data(), blob.size());
+    }
+    for (const auto& output : output_info) {
+        outputs.push_back(output.in_place.has_value() ? inputs[*output.in_place] : allocate(output.getSize()));
+    }
+    finishTransfers();
+    setArguments(dispatch.kernel, test, variant, inputs, outputs);
+    cl::Event kernel_event;
+    m_queue.enqueueNDRangeKernel(dispatch.kernel, toNDRange(test.getNDRange().offset), toNDRange(dispatch.global),
+                                 toNDRange(dispatch.local), nullptr, &kernel_event);
+    kernel_event.wait();
+    std::vector<Test::output_blob> host_outputs(output_info.size());
+    for (size_t i = 0; i < output_info.size(); ++i) {
+        host_outputs[i].resize(output_info[i].getSize());
+        transfer(host_outputs[i].data(), outputs[i], host_outputs[i].size());
+    }
+    finishTransfers();
+
+    double buffer_transfer = 0;
+    for (const auto& upload : dispatch.upload_events) { buffer_transfer += getDuration(upload); }
+    for (const auto& read : dispatch.read_events) { buffer_transfer += getDuration(read); }
+    const double kernel_time = getDuration(kernel_event);
+    const double buffer_kernel_time = getDuration(dispatch.kernel_event);
+    const bool matches = host_outputs == result.outputs;
+    auto& svm = m_svm[fine_grain ? 1 : 0];
+    svm.dispatches++;
+    if (!matches) svm.mismatches++;
+    svm.svm_transfer += transfer_time;
+    svm.svm_kernel += kernel_time;
+    svm.buffer_transfer += buffer_transfer;
+    svm.buffer_kernel += buffer_kernel_time;
+    log << "SVM (" << (fine_grain ? "fine" : "coarse") << "-grained): transfers " << transfer_time
+        << " Microseconds, kernel " << kernel_time << " Microseconds; buffers: transfers " << buffer_transfer
+        << " Microseconds, kernel " << buffer_kernel_time << " Microseconds"
+        << (matches ? "" : "; outputs differ from the buffer dispatch!") << std::endl;
+}
+
+TimingStatistic DeviceRunner::benchmark(const cl::Kernel& kernel, const cl::NDRange& offset, const cl::NDRange& global,
+                                       const cl::NDRange& local) {
+    auto dispatch = [&]() {
+        cl::Event evt;
+        m_queue.enqueueNDRangeKernel(kernel, offset, global, local, nullptr, &evt);
+        evt.wait();  // the queue is out-of-order, timed dispatches must not overlap
+        return evt;
+    };
+    for (unsigned int i = 0; i < m_settings.warmup_iterations; ++i) { dispatch(); }
+
+    const bool fixed_iterations = m_settings.benchmark_iterations > 0;
+    const size_t max_iterations = fixed_iterations ? m_settings.benchmark_iterations
+                                                   : std::max(m_settings.max_benchmark_iterations,
+                                                              m_settings.min_benchmark_iterations);
+    std::vector<TimingSample> samples;
+    while (samples.size() < max_iterations) {
+        const auto evt = dispatch();
+        samples.push_back({evt.getProfilingInfo<CL_PROFILING_COMMAND_QUEUED>(),
+                           evt.getProfilingInfo<CL_PROFILING_COMMAND_SUBMIT>(),
+                           evt.getProfilingInfo<CL_PROFILING_COMMAND_START>(),
+                           evt.getProfilingInfo<CL_PROFILING_COMMAND_END>()});
+        if (fixed_iterations || samples.size() < m_settings.min_benchmark_iterations) continue;
+        const auto stats = TimingStatistic::calculate(samples);
+        if (stats.ci95 <= m_settings.benchmark_precision * stats.mean) break;
+    }
+    return TimingStatistic::calculate(samples);
+}
+
+void DeviceRunner::calibrate() {
+    constexpr size_t warmup = 10, iterations = 100;
+    cl::Program program(m_context, "__kernel void calibration_empty() {}");
+    program.build({m_device});
+    cl::Kernel kernel(program, "calibration_empty");
+
+    std::vector<TimingSample> samples;
+    for (size_t i = 0; i < warmup + iterations; ++i) {
+        cl::Event evt;
+        m_queue.enqueueNDRangeKernel(kernel, cl::NullRange, cl::NDRange(1), cl::NullRange, nullptr, &evt);
+        evt.wait();
+        if (i < warmup) continue;
+        samples.push_back({evt.getProfilingInfo<CL_PROFILING_COMMAND_QUEUED>(),
+                           evt.getProfilingInfo<CL_PROFILING_COMMAND_SUBMIT>(),
+                           evt.getProfilingInfo<CL_PROFILING_COMMAND_START>(),
+                           evt.getProfilingInfo<CL_PROFILING_COMMAND_END>()});
+    }
+    const auto stats = TimingStatistic::calculate(samples);
+    auto& calibration = m_calibration.emplace();
+    calibration.timer_resolution = m_device.getInfo<CL_DEVICE_PROFILING_TIMER_RESOLUTION>() / 1000.0;  // ns -> us
+    calibration.empty_kernel = stats.median;
+    calibration.launch_overhead = stats.queue_to_start;
+    std::cout << "Calibration: timer resolution " << calibration.timer_resolution << " Microseconds, empty kernel "
+              << calibration.empty_kernel << " Microseconds, launch overhead (queued -> start) "
+              << calibration.launch_overhead << " Microseconds" << std::endl;
+}
+
+std::string DeviceRunner::formatCorrectedTime(double kernel_time_us) const {
+    if (!m_calibration.has_value()) return {};
+    std::stringstream ss;
+    ss << " (overhead-corrected: " << m_calibration->correct(kernel_time_us) << " Microseconds";
+    if (!m_calibration->isReliable(kernel_time_us)) {
+        ss << ", UNRELIABLE: below timer resolution " << m_calibration->timer_resolution << " Microseconds";
+    }
+    ss << ")";
+    return ss.str();
+}
+
+void DeviceRunner::runTests() {
+    // Variants are enqueued up to depth ahead: while the host checks the results of one variant, the device
+    // uploads, runs and reads back the next ones
+    const size_t depth = getPipelineDepth();
+    struct Step {
+        size_t test_id;
+        size_t variant_id;
+        std::optional<Dispatch> dispatch;  // empty - every variant of the test is finished, its result is ready
+        uintmax_t device_bytes = 0;         // reserved by the dispatch
+        uintmax_t host_bytes = 0;
+    };
+    struct TestRun {
+        TestResult result;
+        std::stringstream log;
+    };
+    std::deque<Step> steps;
+    std::unordered_map<size_t, TestRun> runs;
+    size_t dispatches = 0;
+    std::vector<cl::Event> queue_tails(m_queues.size());  // last readback of every queue
+    auto finishStep = [&]() {
+        auto& step = steps.front();
+        auto& run = runs.at(step.test_id);
+        if (step.dispatch.has_value()) {
+            dispatches--;
+            const auto& variant = (*m_variants)[step.test_id][step.variant_id];
+            run.result.variants[step.variant_id] =
+                finishDispatch((*m_tests)[step.test_id], variant, m_builds[step.test_id][step.variant_id].get(),
+                               *step.dispatch, run.log);
+        } else {
+            for (const auto& input : (*m_tests)[step.test_id].getInputs()) {
+                m_wrapped_inputs.erase(std::get<2>(input).data());
+            }
+            run.result.log = run.log.str();
+            m_result_promises[step.test_id].set_value(std::move(run.result));
+            runs.erase(step.test_id);
+        }
+        // Unpinned before the release wakes the runners blocked on the budget, they may reclaim the inputs
+        if (step.dispatch.has_value()) step.dispatch->resident_pins.clear();
+        m_device_memory.release(step.device_bytes);
+        m_host_memory.release(step.host_bytes);
+        // Pooled buffers are kept as idle bytes of the budget the dispatch has just released
+        if (step.dispatch.has_value()) {
+            for (auto& buffer : step.dispatch->pooled) {
+                m_buffer_pool->release(m_context, std::move(buffer), m_device_memory);
+            }
+            // The SVM allocations are reserved on their own, the buffers of the dispatch are dropped first
+            if (m_settings.svm && step.dispatch->chunk_kernel_events.empty()) {
+                step.dispatch->inputs.clear();
+                step.dispatch->outputs.clear();
+                compareSvm((*m_tests)[step.test_id], (*m_variants)[step.test_id][step.variant_id], *step.dispatch,
+                           run.result.variants[step.variant_id], run.log);
+            }
+        }
+        steps.pop_front();
+    };
+    // Dispatches are admitted while their buffers fit the budgets, otherwise the idle buffers are reclaimed and
+    // the oldest steps are finished. Blocking is safe only without reservations, when nothing is in flight
+    auto tryReserve = [&](uintmax_t device_bytes, uintmax_t host_bytes) {
+        if (!m_device_memory.tryAcquire(device_bytes) &&
+            !(m_device_memory.reclaim() && m_device_memory.tryAcquire(device_bytes))) {
+            return false;
+        }
+        if (m_host_memory.tryAcquire(host_bytes)) return true;
+        m_device_memory.release(device_bytes);
+        return false;
+    };
+    auto reserve = [&](uintmax_t device_bytes, uintmax_t host_bytes) {
+        for (bool stalled = false;; stalled = true) {
+            if (tryReserve(device_bytes, host_bytes)) {
+                if (stalled) m_memory_stalls++;
+                return;
+            }
+            if (steps.empty()) {
+                m_memory_stalls++;
+                m_device_memory.acquire(device_bytes);
+                m_host_memory.acquire(host_bytes);
+                return;
+            }
+            finishStep();
+        }
+    };
+
+    m_device_intervals.clear();
+    m_dispatch_count = 0;
+    m_memory_stalls = 0;
+    m_uploaded_bytes = 0;
+    m_resident_bytes = 0;
+    m_wrapped_bytes = 0;
+    m_wrapped_inputs.clear();
+    m_svm = {};
+    m_tests_run = 0;
+    const auto run_start = std::chrono::steady_clock::now();
+    try {
+        for (auto next = m_scheduler->next(m_worker); next.has_value(); next = m_scheduler->next(m_worker)) {
+            const size_t test_id = *next;
+            const auto& test = (*m_tests)[test_id];
+            const auto& variants = (*m_variants)[test_id];
+            auto& run = runs[test_id];
+            run.result.variants.resize(variants.size());
+            if (test.isIL() && !m_il_supported) {
+                run.log << "\nTest: " << test.getName() << " is skipped on " << m_label
+                        << ": device doesn't support SPIR-V" << std::endl;
+            }
+
+            //Run test on the device, once per build variant, on the first idle queue or the queues in turn
+            auto queue_id = m_tests_run % m_queues.size();
+            for (size_t i = 0; i < m_queues.size(); ++i) {
+                if (queue_tails[i]() == nullptr ||
+                    queue_tails[i].getInfo<CL_EVENT_COMMAND_EXECUTION_STATUS>() == CL_COMPLETE) {
+                    queue_id = i;
+                    break;
+                }
+            }
+            auto& queue = m_queues[queue_id];
+            // Variants differ in the chunk layout
+            std::vector<uintmax_t> variant_bytes;
+            for (const auto& variant : variants) { variant_bytes.push_back(getFootprint(test, variant)); }
+            const uintmax_t max_device_bytes =
+                variant_bytes.empty() ? 0 : *std::max_element(variant_bytes.begin(), variant_bytes.end());
+            const uintmax_t host_bytes = getHostFootprint(test);
+            const bool device_fits = max_device_bytes <= m_device_memory.getLimit();
+            const bool fits = device_fits && host_bytes <= m_host_memory.getLimit();
+            if (isSupported(test) && !fits) {
+                const auto& budget = device_fits ? m_host_memory : m_device_memory;
+                run.log << "\nTest: " << test.getName() << " is skipped on " << m_label << ": "
+                        << (device_fits ? host_bytes : max_device_bytes) / 1024 << " KiB of buffers exceed the "
+                        << budget.getName() << " memory budget" << std::endl;
+            }
+            const bool runnable = isSupported(test) && fits;
+            if (runnable) m_tests_run++;
+            for (size_t variant_id = 0; runnable && variant_id < variants.size(); ++variant_id) {
+                const auto wait_start = std::chrono::steady_clock::now();
+                if (!isDealt(test_id)) build(test_id, variant_id);  // stolen, nobody builds it for this device
+                const CompiledProgram* compiled = nullptr;
+                try {
+                    compiled = &m_builds[test_id][variant_id].get();
+                } catch (const std::exception& e) {
+                    run.log << "Error during build! Test: " << test.getName() << "\nError : " << e.what()
+                            << std::endl;
+                }
+                m_build_wait_time += std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - wait_start);
+                if (compiled == nullptr) continue;
+                const uintmax_t device_bytes = variant_bytes[variant_id];
+                reserve(device_bytes, host_bytes);
+                std::optional<Dispatch> dispatch;
+                try {
+                    dispatch = enqueueDispatch(test, variants[variant_id], *compiled, queue, run.log);
+                } catch (...) {
+                    // Not in steps yet, the handler below releases only the reservations of the steps
+                    m_device_memory.release(device_bytes);
+                    m_host_memory.release(host_bytes);
+                    throw;
+                }
+                if (!dispatch.has_value()) {
+                    m_device_memory.release(device_bytes);
+                    m_host_memory.release(host_bytes);
+                    continue;
+                }
+                // Inputs bound from or inserted into the input cache are its idle bytes, not the reservation's
+                m_device_memory.release(dispatch->resident_bytes);
+                const uintmax_t cached_bytes = dispatch->resident_bytes + cacheInputs(test, *dispatch);
+                m_dispatch_count++;
+                queue_tails[queue_id] = dispatch->read_event;
+                steps.push_back({test_id, variant_id, std::move(dispatch), device_bytes - cached_bytes, host_bytes});
+                for (dispatches++; dispatches > depth;) { finishStep(); }
+            }
+            steps.push_back({test_id, 0, std::nullopt});
+            while (!steps.empty() && !steps.front().dispatch.has_value()) { finishStep(); }
+        }
+        while (!steps.empty()) { finishStep(); }
+    } catch (...) {
+        // Tests this device has taken fail for the waiting reader instead of blocking it, the rest are stolen
+        for (auto& [test_id, run] : runs) { m_result_promises[test_id].set_exception(std::current_exception()); }
+        for (const auto& step : steps) {
+            m_device_memory.release(step.device_bytes);
+            m_host_memory.release(step.host_bytes);
+        }
+    }
+    m_scheduler->retire();
+    m_run_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - run_start);
+}
+
+std::optional<size_t> DeviceRunner::getChunkElements(const Test& test) const {
+    if (!test.isChunked()) return std::nullopt;
+    const auto& outputs = test.getOutputs();
+    const size_t elements = outputs.front().getSize() / Test::getTypeSize(outputs.front().getType());
+    // Bytes of every blob per output element, every blob of an elementwise kernel has whole bytes per element
+    uintmax_t element_bytes = 0, max_element_bytes = 0, blobs = 0;
+    auto addBlob = [&](size_t blob_size) {
+        if (elements == 0 || blob_size % elements != 0) {
+            throw std::runtime_error("Blob size isn't a multiple of the output elements, the test can't be chunked");
+        }
+        element_bytes += blob_size / elements;
+        blobs++;
+        max_element_bytes = std::max<uintmax_t>(max_element_bytes, blob_size / elements);
+    };
+    for (const auto& input : test.getInputs()) { addBlob(std::get<2>(input).size()); }
+    for (const auto& output : outputs) {
+        if (!output.in_place.has_value()) addBlob(output.getSize());
+    }
+
+    // Every buffer of a chunk fits the allocation limit, both buffer sets fit the device budget. A pooled buffer is
+    // rounded up to its size class, at most 25% and 4 KiB more, and an arena pads its slices to the alignment
+    const uintmax_t buffer_limit = m_settings.chunk_size ? m_settings.chunk_size : m_max_alloc;
+    uintmax_t set_budget = m_device_memory.getLimit() / 2;
+    if (m_buffer_pool && !m_zero_copy) {
+        const uintmax_t slack = 2 * blobs * (m_base_addr_align + 4096);
+        set_budget = (set_budget - std::min(set_budget, slack)) / 5 * 4;
+    }
+    const uintmax_t chunk = std::min(buffer_limit / max_element_bytes, set_budget / element_bytes);
+    if (chunk >= elements) return std::nullopt;
+    return static_cast<size_t>(chunk);
+}
+
+uintmax_t DeviceRunner::cacheInputs(const Test& test, Dispatch& dispatch) {
+    uintmax_t bytes = 0;
+    for (const auto& [input, upload] : dispatch.cache_misses) {
+        const size_t size = std::get<2>(test.getInputs()[input]).size();
+        auto entry = m_input_cache->insert(test.getInputHash(input), size, {dispatch.inputs[input], upload, nullptr});
+        if (!entry.has_value()) continue;
+        dispatch.resident_pins.push_back(std::move(entry->pin));
+        bytes += size;
+    }
+    return bytes;
+}
+
+uintmax_t DeviceRunner::getFootprint(const Test& test, const Test::Variant& variant) const {
+    try {
+        // A chunked dispatch holds two sets of chunk buffers
+        if (const auto chunk = getChunkElements(test); chunk.has_value()) {
+            return 2 * getAllocationSize(getChunkLayout(test, variant, *chunk).buffers);
+        }
+    } catch (const std::exception&) {
+        return test.getFootprint();  // enqueueDispatch reports it
+    }
+    // Cached inputs aren't pooled
+    uintmax_t cached_bytes = 0;
+    std::vector<std::pair<size_t, cl_mem_flags>> buffers;
+    for (size_t i = 0; i < test.getInputs().size(); ++i) {
+        const size_t size = std::get<2>(test.getInputs()[i]).size();
+        if (m_input_cache && !isInPlaceInput(test, i)) {
+            cached_bytes += size;
+        } else {
+            buffers.emplace_back(size, CL_MEM_READ_ONLY);
+        }
+    }
+    for (const auto& output : test.getOutputs()) {
+        if (!output.in_place.has_value()) buffers.emplace_back(output.getSize(), CL_MEM_WRITE_ONLY);
+    }
+    return cached_bytes + getAllocationSize(buffers);
+}
+
+uintmax_t DeviceRunner::getHostFootprint(const Test& test) const {
+    uintmax_t bytes = 0;
+    for (const auto& output : test.getOutputs()) { bytes += output.getSize(); }
+    return bytes;
+}
+
+DeviceRunner::ChunkLayout DeviceRunner::getChunkLayout(const Test& test, const Test::Variant& variant,
+                                                       size_t chunk_elements) const {
+    const auto& outputs = test.getOutputs();
+    ChunkLayout layout;
+    layout.total_items =
+        getGlobalSize(test, variant, outputs.front().getSize() / Test::getTypeSize(outputs.front().getType()))[0];
+    // A chunk is a whole number of work-groups
+    const auto& local = test.getNDRange().local;
+    const size_t group = local.empty() ? 1 : local[0];
+    layout.chunk_items = chunk_elements / variant.specialization.items_per_work_item / group * group;
+    if (layout.chunk_items == 0) {
+        throw std::runtime_error("Chunk of " + std::to_string(chunk_elements) + " elements is less than a work-group");
+    }
+    auto chunkBytes = [&](size_t blob_size) { return blob_size / layout.total_items * layout.chunk_items; };
+    for (size_t i = 0; i < test.getInputs().size(); ++i) {
+        layout.buffers.emplace_back(chunkBytes(std::get<2>(test.getInputs()[i]).size()),
+                                    isInPlaceInput(test, i) ? CL_MEM_READ_WRITE : CL_MEM_READ_ONLY);
+    }
+    for (const auto& output : outputs) {
+        if (!output.in_place.has_value()) layout.buffers.emplace_back(chunkBytes(output.getSize()), CL_MEM_WRITE_ONLY);
+    }
+    return layout;
+}
+
+void DeviceRunner::enqueueChunks(const Test& test, const Test::Variant& variant, size_t chunk_elements,
+                                 cl::CommandQueue& queue, Dispatch& dispatch) {
+    const auto& outputs = test.getOutputs();
+    dispatch.global =
+        getGlobalSize(test, variant, outputs.front().getSize() / Test::getTypeSize(outputs.front().getType()));
+    dispatch.local = test.getNDRange().local;
+    checkLocalSize(dispatch.kernel, dispatch.global, dispatch.local);
+    const auto layout = getChunkLayout(test, variant, chunk_elements);
+    const size_t total_items = layout.total_items;
+    const size_t chunk_items = layout.chunk_items;
+    auto itemBytes = [&](size_t blob_size) { return blob_size / total_items; };
+
+    // Chunk k uses buffer set k % 2, the set is reused once the readback of chunk k - 2 has finished
+    struct BufferSet {
+        std::vector<cl::Buffer> inputs;
+        std::vector<cl::Buffer> outputs;  // an in-place output is its input buffer
+        std::vector<cl::Event> released;
+    };
+    BufferSet sets[2];
+    for (auto& set : sets) {
+        const auto buffers = allocateBuffers(layout.buffers, dispatch);
+        dispatch.chunk_buffers.insert(dispatch.chunk_buffers.end(), buffers.begin(), buffers.end());
+        set.inputs.assign(buffers.begin(), buffers.begin() + test.getInputs().size());
+        for (size_t next = set.inputs.size(); const auto& output : outputs) {
+            set.outputs.push_back(output.in_place.has_value() ? set.inputs[*output.in_place] : buffers[next++]);
+        }
+    }
+    dispatch.host_outputs.resize(outputs.size());
+    for (size_t i = 0; i < outputs.size(); ++i) { dispatch.host_outputs[i].resize(outputs[i].getSize()); }
+    for (size_t begin = 0, chunk = 0; begin < total_items; begin += chunk_items, ++chunk) {
+        const size_t items = std::min(chunk_items, total_items - begin);
+        auto& set = sets[chunk % 2];
+        auto kernel_wait = set.released;
+        for (size_t i = 0; i < set.inputs.size(); ++i) {
+            const auto& blob = std::get<2>(test.getInputs()[i]);
+            const size_t item_bytes = itemBytes(blob.size());
+            dispatch.upload_events.emplace_back();
+            queue.enqueueWriteBuffer(set.inputs[i], CL_FALSE, 0, item_bytes * items, blob.data() + item_bytes * begin,
+                                     set.released.empty() ? nullptr : &set.released, &dispatch.upload_events.back());
+            kernel_wait.push_back(dispatch.upload_events.back());
+            m_uploaded_bytes += item_bytes * items;
+        }
+        setArguments(dispatch.kernel, test, variant, set.inputs, set.outputs);
+        dispatch.chunk_kernel_events.emplace_back();
+        queue.enqueueNDRangeKernel(dispatch.kernel, cl::NDRange(begin), cl::NDRange(items), toNDRange(dispatch.local),
+                                   kernel_wait.empty() ? nullptr : &kernel_wait, &dispatch.chunk_kernel_events.back());
+        const std::vector<cl::Event> kernel_done = {dispatch.chunk_kernel_events.back()};
+        set.released.clear();
+        for (size_t i = 0; i < outputs.size(); ++i) {
+            const size_t item_bytes = itemBytes(outputs[i].getSize());
+            dispatch.read_events.emplace_back();
+            queue.enqueueReadBuffer(set.outputs[i], CL_FALSE, 0, item_bytes * items,
+                                    dispatch.host_outputs[i].data() + item_bytes * begin, &kernel_done,
+                                    &dispatch.read_events.back());
+            set.released.push_back(dispatch.read_events.back());
+        }
+    }
+    dispatch.kernel_event = dispatch.chunk_kernel_events.back();
+    dispatch.read_event = getCompletion(queue, dispatch.read_events);
+    queue.flush();
+}
+
+std::vector<cl::Buffer> DeviceRunner::allocateBuffers(const std::vector<std::pair<size_t, cl_mem_flags>>& buffers,
+                                                      Dispatch& dispatch) {
+    std::vector<cl::Buffer> allocated;
+    if (m_zero_copy) {
+        // Host-accessible memory the readbacks map, pooled buffers may live in device memory
+        for (const auto& [size, flags] : buffers) {
+            allocated.emplace_back(m_context, flags | CL_MEM_ALLOC_HOST_PTR, size);
+        }
+    } else if (!m_buffer_pool) {
+        for (const auto& [size, flags] : buffers) { allocated.emplace_back(m_context, flags, size); }
+    } else if (isArena(buffers)) {
+        std::vector<size_t> sizes;
+        for (const auto& buffer : buffers) { sizes.push_back(buffer.first); }
+        auto arena = m_buffer_pool->acquireArena(m_context, sizes, m_base_addr_align, m_max_alloc);
+        dispatch.pooled.push_back(std::move(arena.buffer));
+        allocated = std::move(arena.slices);
+    } else {
+        for (const auto& buffer : buffers) {
+            allocated.push_back(m_buffer_pool->acquire(m_context, buffer.first, m_max_alloc));
+            dispatch.pooled.push_back(allocated.back());
+        }
+    }
+    return allocated;
+}
+
+bool DeviceRunner::isArena(const std::vector<std::pair<size_t, cl_mem_flags>>& buffers) const {
+    // An arena over the max allocation size can't be allocated, the buffers are pooled one by one
+    if (m_settings.buffer_allocation != "arena") return false;
+    std::vector<size_t> sizes;
+    for (const auto& buffer : buffers) { sizes.push_back(buffer.first); }
+    return BufferPool::getArenaSize(sizes, m_base_addr_align) <= m_max_alloc;
+}
+
+uintmax_t DeviceRunner::getAllocationSize(const std::vector<std::pair<size_t, cl_mem_flags>>& buffers) const {
+    uintmax_t bytes = 0;
+    if (m_zero_copy || !m_buffer_pool) {
+        for (const auto& buffer : buffers) { bytes += buffer.first; }
+    } else if (isArena(buffers)) {
+        std::vector<size_t> sizes;
+        for (const auto& buffer : buffers) { sizes.push_back(buffer.first); }
+        bytes = BufferPool::getAllocationSize(BufferPool::getArenaSize(sizes, m_base_addr_align), m_max_alloc);
+    } else {
+        for (const auto& buffer : buffers) { bytes += BufferPool::getAllocationSize(buffer.first, m_max_alloc); }
+    }
+    return bytes;
+}
+
+size_t DeviceRunner::getPipelineDepth() const noexcept {
+    // Benchmark and autotune time dispatches alone, other commands on the device would skew the times. The SVM
+    // comparison blocks on the budgets, which is safe only while the runner holds no reservation
+    if (m_settings.benchmark || m_settings.autotune || m_settings.svm) return 0;
+    return std::max<size_t>(m_settings.pipeline_depth, m_queues.size());  // every queue gets work
+}
+
+std::chrono::steady_clock::time_point DeviceRunner::getLastBuildFinish() const {
+    std::chrono::steady_clock::time_point finish;
+    for (const auto& test_builds : m_builds) {
+        for (const auto& build : test_builds) {
+            if (!build.valid() || build.wait_for(std::chrono::seconds(0)) != std::future_status::ready) continue;
+            try {
+                finish = std::max(finish, build.get().finish_time);
+            } catch (const std::exception&) {}
+        }
+    }
+    return finish;
+}
+
+void DeviceRunner::printSummary(std::chrono::steady_clock::time_point builds_start) const {
+    std::cout << m_label << ": " << getName() << " (" << getTypeName(m_type) << ", " << m_compute_units
+              << " compute units)" << std::endl;
+    if (m_calibration.has_value()) {
+        std::cout << "  Calibration: timer resolution " << m_calibration->timer_resolution
+                  << " Microseconds, empty kernel " << m_calibration->empty_kernel << " Microseconds" << std::endl;
+    }
+
+    size_t programs = 0;
+    std::chrono::microseconds build_time{0};
+    // Front-end and back-end time of OpenCL C [0] and SPIR-V [1] programs built from scratch
+    std::chrono::microseconds frontend_time[2] = {}, backend_time[2] = {};
+    size_t built[2] = {};
+    auto builds_finish = builds_start;
+    for (size_t test_id = 0; test_id < m_builds.size(); ++test_id) {
+        for (const auto& build : m_builds[test_id]) {
+            if (!build.valid() || build.wait_for(std::chrono::seconds(0)) != std::future_status::ready) continue;
+            try {
+                const auto& compiled = build.get();
+                programs++;
+                build_time += compiled.build_time;
+                builds_finish = std::max(builds_finish, compiled.finish_time);
+                if (compiled.from_cache) continue;
+                const size_t kind = (*m_tests)[test_id].isIL() ? 1 : 0;
+                built[kind]++;
+                frontend_time[kind] += compiled.frontend_time;
+                backend_time[kind] += compiled.backend_time;
+            } catch (const std::exception&) {}
+        }
+    }
+    const auto build_wall_time =
+        std::chrono::duration_cast<std::chrono::microseconds>(builds_finish - builds_start);
+    std::cout << "  Build: " << programs << " programs, " << build_time.count() / 1000 << " ms total build time, "
+              << build_wall_time.count() / 1000 << " ms wall time, " << m_build_wait_time.count() / 1000
+              << " ms waited by runTests" << std::endl;
+    const char* kind_names[2] = {"OpenCL C", "SPIR-V"};
+    for (size_t kind = 0; kind < 2; ++kind) {
+        if (built[kind] == 0) continue;
+        std::cout << "    " << kind_names[kind] << ": " << built[kind] << " programs built, front-end "
+                  << frontend_time[kind].count() / 1000 << " ms, back-end " << backend_time[kind].count() / 1000
+                  << " ms" << std::endl;
+    }
+    if (!m_device_intervals.empty()) {
+        // Union of the device time of uploads, kernels and readbacks, overlapping commands are counted once
+        auto intervals = m_device_intervals;
+        std::sort(intervals.begin(), intervals.end());
+        cl_ulong busy = 0, commands = 0;
+        auto [begin, end] = intervals.front();
+        for (const auto& [start, finish] : intervals) {
+            commands += finish - start;
+            if (start > end) {
+                busy += end - begin;
+                begin = start;
+            }
+            end = std::max(end, finish);
+        }
+        busy += end - begin;
+        const auto span = end - intervals.front().first;
+        std::cout << "  Pipeline: depth " << getPipelineDepth() << ", "
+                  << (m_settings.queue_count ? std::to_string(m_queues.size()) + " in-order" : "1 out-of-order")
+                  << " queues, device busy " << (span ? 100.0 * busy / span : 100.0) << "% of " << span / 1000000.0
+                  << " ms, commands overlap " << (busy ? double(commands) / busy : 1.0) << "x" << std::endl;
+        // A single in-order queue runs the same commands back to back
+        const auto run_seconds = std::max(m_run_time.count() / 1e6, 1e-6);
+        std::cout << "  Throughput: " << m_tests_run << " tests, " << m_dispatch_count << " dispatches in "
+                  << m_run_time.count() / 1000 << " ms, " << m_tests_run / run_seconds << " tests/s, "
+                  << m_dispatch_count / run_seconds << " dispatches/s; single queue baseline " << commands / 1000000.0
+                  << " ms of device time, " << (span ? double(commands) / span : 1.0) << "x speedup" << std::endl;
+        if (m_scheduler->getWorkersCount() > 1) {
+            // Device busy time against the time the whole group spent on the suite
+            const auto statistic = m_scheduler->getStatistic(m_worker);
+            const auto group_time = m_scheduler->getWallTime().count();
+            std::cout << "  Scheduler: worker " << m_worker << " of " << m_scheduler->getWorkersCount() << ", "
+                      << statistic.tests << " tests, " << statistic.stolen << " stolen, utilization "
+                      << (group_time ? std::min(100.0, busy / 10.0 / group_time) : 100.0) << "% of "
+                      << group_time / 1000 << " ms" << std::endl;
+        }
+        if (m_memory_stalls > 0) {
+            std::cout << "  Memory: " << m_memory_stalls << " dispatches waited for the memory of dispatches in flight"
+                      << std::endl;
+        }
+        std::cout << "  Inputs: " << m_uploaded_bytes / 1024 << " KiB uploaded, " << m_resident_bytes / 1024
+                  << " KiB bound from the input cache, " << m_wrapped_bytes / 1024 << " KiB used in place";
+        if (m_input_cache) {
+            const auto stats = m_input_cache->getStatistic();
+            std::cout << " (" << stats.hits << " hits, " << stats.misses << " misses, " << stats.evicted
+                      << " evicted, peak " << stats.peak_bytes / 1024 << " KiB)";
+        }
+        std::cout << std::endl;
+        for (size_t fine = 0; fine < m_svm.size(); ++fine) {
+            const auto& svm = m_svm[fine];
+            if (svm.dispatches == 0) continue;
+            std::cout << "  SVM (" << (fine ? "fine" : "coarse") << "-grained): " << svm.dispatches
+                      << " dispatches, transfers " << svm.svm_transfer / 1000 << " ms vs " << svm.buffer_transfer / 1000
+                      << " ms with buffers, kernels " << svm.svm_kernel / 1000 << " ms vs "
+                      << svm.buffer_kernel / 1000 << " ms, " << svm.mismatches << " outputs differ" << std::endl;
+        }
+    }
+}
+
+CompiledProgram DeviceRunner::compileProgram(const Test& test, const Test::Variant& variant) {
+    const auto start = std::chrono::steady_clock::now();
+    CompiledProgram compiled;
+    auto finish = [&start, &compiled](bool from_cache) {
+        compiled.from_cache = from_cache;
+        compiled.finish_time = std::chrono::steady_clock::now();
+        compiled.build_time = std::chrono::duration_cast<std::chrono::microseconds>(compiled.finish_time - start);
+        return std::move(compiled);
+    };
+    std::string options = "-Werror";  // see https://man.opencl.org/clBuildProgram.html
+    if (!variant.options.empty()) options += " " + variant.options;
+    const auto program = test.getProgram().specialize(variant.specialization.parameters);
+    compiled.id = getProgramId(test, program);
+    std::string cache_key;
+    if (m_program_cache) {
+        cache_key = ProgramCache::makeKey(compiled.id, options, m_device);
+        if (auto binary = m_program_cache->load(cache_key); binary.has_value()) {
+            try {
+                compiled.program = cl::Program(m_context, {m_device}, cl::Program::Binaries{std::move(*binary)});
+                compiled.program.build({m_device}, options.c_str());
+                return finish(true);
+            } catch (const std::exception& e) {
+                std::cout << "Warning: cached program binary is rejected, rebuilding from source. Error: " << e.what()
+                          << std::endl;
+                m_program_cache->invalidate(cache_key);
+            }
+        }
+    }
+
+    if (test.isIL() && test.getLibraries().empty()) {
+        // SPIR-V has already passed the OpenCL C front-end, the whole build is back-end work
+        const auto backend_start = std::chrono::steady_clock::now();
+        compiled.program = cl::Program(m_context, program.il);
+        try {
+            compiled.program.build({m_device}, options.c_str());
+        } catch (const std::exception& e) { throw getBuildError(compiled.program, e.what()); }
+        compiled.backend_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() -
+                                                                                      backend_start);
+    } else {
+        linkProgram(test, program, options, compiled);
+    }
+
+    if (m_program_cache) m_program_cache->store(cache_key, getDeviceBinary(compiled.program, m_device));
+    return finish(false);
+}
+
+void DeviceRunner::linkProgram(const Test& test, const CompileUnit& program, const std::string& options,
+                              CompiledProgram& compiled) {
+    std::vector<CompiledObject> objects = {getCompiledObject(program, options)};
+    for (const auto& library : test.getLibraries()) { objects.emplace_back(getCompiledObject(library, options)); }
+
+    std::vector<cl_program> object_ids;
+    for (const auto& object : objects) {
+        object_ids.push_back(object.program());
+        (object.is_il ? compiled.backend_time : compiled.frontend_time) += object.compile_time;
+    }
+    const auto link_start = std::chrono::steady_clock::now();
+    cl_device_id device_id = m_device();
+    cl_int error = CL_SUCCESS;
+    const auto link_options = getLinkOptions(options);
+    cl_program linked =
+        clLinkProgram(m_context(), 1, &device_id, link_options.c_str(), static_cast<cl_uint>(object_ids.size()),
+                      object_ids.data(), nullptr, nullptr, &error);
+    if (linked != nullptr) compiled.program = cl::Program(linked);
+    if (error != CL_SUCCESS) {
+        if (linked == nullptr) throw std::runtime_error("clLinkProgram error: " + std::to_string(error));
+        throw getBuildError(compiled.program, "clLinkProgram error: " + std::to_string(error));
+    }
+    compiled.backend_time +=
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - link_start);
+}
+
+DeviceRunner::CompiledObject DeviceRunner::getCompiledObject(const CompileUnit& unit, const std::string& options) {
+    // Every unit is compiled once per run, whichever test needs it first does the work and gets its compile time
+    std::promise<cl::Program> promise;
+    std::shared_future<cl::Program> object;
+    bool owner = false;
+    {
+        std::lock_guard lock(m_objects_mutex);
+        auto [it, inserted] = m_objects.try_emplace(unit.hash + '\0' + options);
+        if (inserted) {
+            it->second = promise.get_future().share();
+            owner = true;
+        }
+        object = it->second;
+    }
+    CompiledObject compiled{{}, std::chrono::microseconds(0), !unit.il.empty()};
+    if (owner) {
+        const auto start = std::chrono::steady_clock::now();
+        try {
+            promise.set_value(compileObject(unit, options));
+        } catch (...) { promise.set_exception(std::current_exception()); }
+        compiled.compile_time =
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    }
+    compiled.program = object.get();
+    return compiled;
+}
+
+cl::Program DeviceRunner::compileObject(const CompileUnit& unit, const std::string& options) {
+    std::string cache_key;
+    if (m_program_cache) {
+        cache_key = ProgramCache::makeKey("object:" + unit.hash, options, m_device);
+        if (auto binary = m_program_cache->load(cache_key); binary.has_value()) {
+            try {
+                cl::Program object(m_context, {m_device}, cl::Program::Binaries{std::move(*binary)});
+                if (object.getBuildInfo<CL_PROGRAM_BINARY_TYPE>(m_device) == CL_PROGRAM_BINARY_TYPE_COMPILED_OBJECT) {
+                    return object;
+                }
+            } catch (const std::exception&) {}
+            m_program_cache->invalidate(cache_key);
+        }
+    }
+
+    std::vector<cl::Program> headers;
+    std::vector<cl_program> header_ids;
+    std::vector<const char*> header_names;
+    for (const auto& [name, source] : unit.headers) {
+        headers.emplace_back(m_context, source);
+        header_ids.push_back(headers.back()());
+        header_names.push_back(name.c_str());
+    }
+    cl::Program object = unit.il.empty() ? cl::Program(m_context, unit.source) : cl::Program(m_context, unit.il);
+    cl_device_id device_id = m_device();
+    const cl_int error =
+        clCompileProgram(object(), 1, &device_id, options.c_str(), static_cast<cl_uint>(header_ids.size()),
+                         header_ids.data(), header_names.data(), nullptr, nullptr);
+    if (error != CL_SUCCESS) {
+        throw getBuildError(object, "clCompileProgram error: " + std::to_string(error) + ", unit: " + unit.name);
+    }
+
+    if (m_program_cache) m_program_cache->store(cache_key, getDeviceBinary(object, m_device));
+    return object;
+}
+
+}  // namespace Tester
@@ -0,0 +1,62 @@
+#include "InputCache.hpp"
+
+#include <algorithm>
+
+namespace Tester {
+
+InputCache::InputCache(uintmax_t size_limit, MemoryBudget& budget) : m_size_limit(size_limit), m_budget(budget) {}
+
+InputCache::~InputCache() { m_budget.releaseIdle(m_bytes); }
+
+std::optional<InputCache::Entry> InputCache::find(const std::string& hash) {
+    std::lock_guard lock(m_mutex);
+    auto it = m_slots.find(hash);
+    if (it == m_slots.end()) {
+        m_statistic.misses++;
+        return std::nullopt;
+    }
+    m_statistic.hits++;
+    m_uses.splice(m_uses.begin(), m_uses, it->second.use);
+    return it->second.entry;
+}
+
+std::optional<InputCache::Entry> InputCache::insert(const std::string& hash, uintmax_t bytes, Entry entry) {
+    std::lock_guard lock(m_mutex);
+    if (bytes > m_size_limit || m_slots.contains(hash)) return std::nullopt;
+    while (m_bytes + bytes > m_size_limit) {
+        if (!evictOldest()) return std::nullopt;
+    }
+    m_budget.convertToIdle(bytes);
+    entry.pin = std::make_shared<bool>();
+    m_uses.push_front(hash);
+    m_slots.emplace(hash, Slot{entry, bytes, m_uses.begin()});
+    m_bytes += bytes;
+    m_statistic.peak_bytes = std::max(m_statistic.peak_bytes, m_bytes);
+    return entry;
+}
+
+void InputCache::clear() {
+    std::lock_guard lock(m_mutex);
+    while (evictOldest()) {}
+}
+
+InputCache::Statistic InputCache::getStatistic() const {
+    std::lock_guard lock(m_mutex);
+    return m_statistic;
+}
+
+bool InputCache::evictOldest() {
+    // Copies of a pin are made under the lock, a stale count only keeps an entry longer
+    auto use = std::find_if(m_uses.rbegin(), m_uses.rend(),
+                            [&](const std::string& hash) { return m_slots.at(hash).entry.pin.use_count() == 1; });
+    if (use == m_uses.rend()) return false;
+    auto oldest = m_slots.find(*use);
+    m_bytes -= oldest->second.bytes;
+    m_budget.releaseIdle(oldest->second.bytes);
+    m_slots.erase(oldest);
+    m_uses.erase(std::next(use).base());
+    m_statistic.evicted++;
+    return true;
+}
+
+}  // namespace Tester
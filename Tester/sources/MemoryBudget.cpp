@@ -0,0 +1,83 @@
+#include "MemoryBudget.hpp"
+
+#include <algorithm>
+
+namespace Tester {
+
+MemoryBudget::MemoryBudget(std::string name, uintmax_t limit) : m_name(std::move(name)), m_limit(limit) {}
+
+bool MemoryBudget::tryAcquire(uintmax_t bytes) {
+    std::lock_guard lock(m_mutex);
+    if (m_used + bytes > m_limit) return false;
+    m_used += bytes;
+    m_peak = std::max(m_peak, m_used - m_idle);
+    return true;
+}
+
+void MemoryBudget::acquire(uintmax_t bytes) {
+    std::unique_lock lock(m_mutex);
+    while (m_used + bytes > m_limit) {
+        // The reclaimers take the locks of their caches and release the idle bytes, the mutex isn't held
+        if (m_idle > 0) {
+            lock.unlock();
+            reclaim();
+            lock.lock();
+            if (m_used + bytes <= m_limit) break;
+        }
+        m_released.wait(lock);
+    }
+    m_used += bytes;
+    m_peak = std::max(m_peak, m_used - m_idle);
+}
+
+void MemoryBudget::release(uintmax_t bytes) {
+    {
+        std::lock_guard lock(m_mutex);
+        m_used -= std::min(m_used, bytes);
+    }
+    m_released.notify_all();
+}
+
+bool MemoryBudget::tryAcquireIdle(uintmax_t bytes) {
+    std::lock_guard lock(m_mutex);
+    if (m_used + bytes > m_limit) return false;
+    m_used += bytes;
+    m_idle += bytes;
+    return true;
+}
+
+void MemoryBudget::convertToIdle(uintmax_t bytes) {
+    std::lock_guard lock(m_mutex);
+    m_idle += bytes;
+}
+
+void MemoryBudget::releaseIdle(uintmax_t bytes) {
+    {
+        std::lock_guard lock(m_mutex);
+        m_idle -= std::min(m_idle, bytes);
+    }
+    release(bytes);
+}
+
+void MemoryBudget::addReclaimer(std::function<void()> reclaimer) {
+    std::lock_guard lock(m_mutex);
+    m_reclaimers.push_back(std::move(reclaimer));
+}
+
+bool MemoryBudget::reclaim() {
+    std::vector<std::function<void()>> reclaimers;
+    {
+        std::lock_guard lock(m_mutex);
+        if (m_idle == 0) return false;
+        reclaimers = m_reclaimers;
+    }
+    for (const auto& reclaimer : reclaimers) { reclaimer(); }
+    return true;
+}
+
+uintmax_t MemoryBudget::getPeak() const {
+    std::lock_guard lock(m_mutex);
+    return m_peak;
+}
+
+}  // namespace Tester
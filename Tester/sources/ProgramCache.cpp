@@ -0,0 +1,114 @@
+#include "ProgramCache.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+#include "hashpp.h"
+
+namespace fs = std::filesystem;
+
+namespace Tester {
+
+ProgramCache::ProgramCache(std::filesystem::path directory, uintmax_t size_limit)
+    : m_directory(std::move(directory)), m_size_limit(size_limit) {
+    m_directory.make_preferred();
+    std::error_code ec;
+    fs::create_directories(m_directory, ec);
+    if (ec) { throw std::runtime_error("ProgramCache: Can't create cache directory: " + m_directory.string()); }
+}
+
+/*static*/ std::string ProgramCache::makeKey(std::string_view source, std::string_view options,
+                                             const cl::Device& device) {
+    std::string data;
+    data.append(source).push_back('\0');
+    data.append(options).push_back('\0');
+    data.append(device.getInfo<CL_DEVICE_NAME>()).push_back('\0');
+    data.append(device.getInfo<CL_DRIVER_VERSION>());
+    return hashpp::get::getHash(hashpp::ALGORITHMS::MD5, data).getString();
+}
+
+std::optional<std::vector<unsigned char>> ProgramCache::load(const std::string& key) {
+    std::lock_guard lock(m_mutex);
+    const auto path = getEntryPath(key);
+    std::error_code ec;
+    const auto size = fs::file_size(path, ec);
+    std::ifstream file(path, std::ios::binary);
+    if (ec || size == 0 || !file.is_open()) {
+        m_statistic.misses++;
+        return std::nullopt;
+    }
+    std::vector<unsigned char> binary(size);
+    if (!file.read(reinterpret_cast<char*>(binary.data()), size)) {
+        m_statistic.misses++;
+        return std::nullopt;
+    }
+    fs::last_write_time(path, fs::file_time_type::clock::now(), ec);  // mark as recently used
+    m_statistic.hits++;
+    return binary;
+}
+
+void ProgramCache::store(const std::string& key, const std::vector<unsigned char>& binary) {
+    if (binary.empty()) return;
+    std::lock_guard lock(m_mutex);
+    const auto path = getEntryPath(key);
+    auto tmp_path = path;
+    tmp_path += ".tmp";
+    {
+        std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!file.write(reinterpret_cast<const char*>(binary.data()), binary.size())) {
+            std::cout << "Warning: Can't write program cache entry: " << tmp_path << std::endl;
+            return;
+        }
+    }
+    std::error_code ec;
+    fs::rename(tmp_path, path, ec);  // readers never see a partially written binary
+    if (ec) {
+        fs::remove(tmp_path, ec);
+        return;
+    }
+    evict();
+}
+
+void ProgramCache::invalidate(const std::string& key) {
+    // Called when a loaded binary is rejected by the driver, so the hit turns into a miss
+    std::lock_guard lock(m_mutex);
+    std::error_code ec;
+    fs::remove(getEntryPath(key), ec);
+    if (m_statistic.hits > 0) m_statistic.hits--;
+    m_statistic.misses++;
+}
+
+ProgramCache::Statistic ProgramCache::getStatistic() const {
+    std::lock_guard lock(m_mutex);
+    return m_statistic;
+}
+
+std::filesystem::path ProgramCache::getEntryPath(const std::string& key) const {
+    return m_directory / (key + ".bin");
+}
+
+void ProgramCache::evict() {
+    struct Entry {
+        fs::path path;
+        uintmax_t size;
+        fs::file_time_type last_use;
+    };
+    std::vector<Entry> entries;
+    uintmax_t total_size = 0;
+    std::error_code ec;
+    for (const auto& file : fs::directory_iterator(m_directory, ec)) {
+        if (!file.is_regular_file() || file.path().extension() != ".bin") continue;
+        entries.push_back({file.path(), file.file_size(), file.last_write_time()});
+        total_size += entries.back().size;
+    }
+    std::sort(entries.begin(), entries.end(), [](const auto& l, const auto& r) { return l.last_use < r.last_use; });
+    for (auto it = entries.begin(); it != entries.end() && total_size > m_size_limit; ++it) {
+        if (!fs::remove(it->path, ec)) continue;
+        total_size -= it->size;
+        m_statistic.evicted++;
+    }
+    m_statistic.size = total_size;
+}
+
+}  // namespace Tester
@@ -98,6 +98,7 @@ void TableResults::show(const size_t data_size, TestStatistic&& stats) const {
         std::string str = std::format("{}: PASS", m_table_name);
         drawTextLine(std::move(str), line_size);
         drawLine(index_space_width);
+        drawColumnsSummary(stats);
         std::cout << m_ss.str();
         return;
     }
@@ -166,14 +167,37 @@ void TableResults::show(const size_t data_size, TestStatistic&& stats) const {
     }
 
     m_ss <<  std::format("|{:-^{}}|\n", "", 49);
+    drawColumnsSummary(stats);
     std::cout << m_ss.str() << std::endl;
     }
+
+void TableResults::drawColumnsSummary(const TestStatistic& stats) const {
+    if (std::none_of(m_columns_time.cbegin(), m_columns_time.cend(), [](const auto& t) { return t.has_value(); })) {
+        return;
+    }
+    m_ss << std::format("|{:-^{}}|\n", "", 49);
+    drawTextLineLeft(std::format(" {:<15}{:>12}{:>12}{:>9}", "Column", "Kernel, us", "Max DIFF", "Result"), 49);
+    for (size_t i = 1; i < m_columns_names.size(); ++i) {
+        if (!m_columns_time[i].has_value()) continue;
+        const auto& diff = stats.diffs[i - 1];
+        drawTextLineLeft(std::format(" {:<15.15}{:>12.2f}{:>12.4g}{:>9}", m_columns_names[i], *m_columns_time[i],
+                                     diff.max_mismatch, diff.mismatch_count == 0 ? "PASS" : "DIFF"),
+                         49);
+    }
+    m_ss << std::format("|{:-^{}}|\n", "", 49);
+}
+
+void TableResults::setColumnTime(std::string_view column_name, double microseconds) {
+    auto it = std::find(m_columns_names.cbegin(), m_columns_names.cend(), column_name);
+    if (it == m_columns_names.cend()) throw std::runtime_error("setColumnTime: Unknown column");
+    m_columns_time[std::distance(m_columns_names.cbegin(), it)] = microseconds;
+}
 TableResults::TableResults(std::string table_name, unsigned int cell_width, unsigned int packetSize,
                                       unsigned int tableHeight)
     : m_cell_width(cell_width), m_packet_size(packetSize), m_table_name(std::move(table_name)),
       m_table_height(tableHeight) {}
 
-void TableResults::processAndShow() {
+TestStatistic TableResults::processAndShow() {
     if (m_columns_data.empty()) { throw std::runtime_error("Table.processAndShow(): Empty columns data"); }
     if (m_columns_data.size() == 1) { throw std::runtime_error("Table.processAndShow(): Only one data row"); }
     reset();
@@ -193,8 +217,9 @@ void TableResults::processAndShow() {
         [&](const auto& col) { return col.index() == (m_columns_data.front()).index(); });
 
     if (all_types_are_equal) {
-        show(data_size, getStatistics(data_size));
-        return;
+        auto stats = getStatistics(data_size);
+        show(data_size, TestStatistic(stats));
+        return stats;
     }
 
     m_columns_data_unconverted = m_columns_data;
@@ -215,7 +240,9 @@ void TableResults::processAndShow() {
         changeVectorsType<int64_t>(m_columns_data);
         std::cout << "\n* Table: all data types are converted to int64! *\n";
     }
-    show(data_size, getStatistics(data_size));
+    auto stats = getStatistics(data_size);
+    show(data_size, TestStatistic(stats));
+    return stats;
 }
 
 std::optional<size_t> TableResults::findFirstMismatch(unsigned int dataSize) const {   
@@ -271,6 +298,7 @@ void TableResults::clear() {
     m_info_columns_names.clear();
     m_columns_data.clear();
     m_info_columns_data.clear();
+    m_columns_time.clear();
     reset();
 }
 
@@ -0,0 +1,64 @@
+#include "TestScheduler.hpp"
+
+#include <algorithm>
+
+namespace Tester {
+
+TestScheduler::TestScheduler(size_t workers, size_t tests)
+    : m_deques(workers), m_statistics(workers), m_worker_promises(tests) {
+    for (size_t test_id = 0; test_id < tests; ++test_id) {
+        m_deques[getDealtWorker(test_id)].push_back(test_id);
+        m_workers.emplace_back(m_worker_promises[test_id].get_future().share());
+    }
+}
+
+std::optional<size_t> TestScheduler::next(size_t worker) {
+    std::lock_guard lock(m_mutex);
+    if (!m_start.has_value()) m_start = std::chrono::steady_clock::now();
+    auto* deque = &m_deques[worker];
+    const bool steal = deque->empty();
+    if (steal) {
+        deque = &*std::max_element(m_deques.begin(), m_deques.end(),
+                                   [](const auto& a, const auto& b) { return a.size() < b.size(); });
+        if (deque->empty()) return std::nullopt;
+    }
+    size_t test_id;
+    if (steal) {
+        test_id = deque->back();
+        deque->pop_back();
+        m_statistics[worker].stolen++;
+    } else {
+        test_id = deque->front();
+        deque->pop_front();
+    }
+    m_statistics[worker].tests++;
+    m_worker_promises[test_id].set_value(worker);
+    return test_id;
+}
+
+void TestScheduler::retire() {
+    std::lock_guard lock(m_mutex);
+    if (++m_retired < m_statistics.size()) return;
+    m_finish = std::chrono::steady_clock::now();
+    for (auto& deque : m_deques) {
+        for (auto test_id : deque) { m_worker_promises[test_id].set_value(no_worker); }
+        deque.clear();
+    }
+}
+
+size_t TestScheduler::getWorker(size_t test_id) const {
+    return m_workers.at(test_id).get();
+}
+
+TestScheduler::WorkerStatistic TestScheduler::getStatistic(size_t worker) const {
+    std::lock_guard lock(m_mutex);
+    return m_statistics.at(worker);
+}
+
+std::chrono::microseconds TestScheduler::getWallTime() const {
+    std::lock_guard lock(m_mutex);
+    if (!m_start.has_value() || m_retired < m_statistics.size()) return std::chrono::microseconds{0};
+    return std::chrono::duration_cast<std::chrono::microseconds>(m_finish - *m_start);
+}
+
+}  // namespace Tester
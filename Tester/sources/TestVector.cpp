@@ -1,28 +1,206 @@
 #include <json.hpp>
 #include <iostream>
 #include <fstream>
+#include <map>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
 #include <exception>
 
 #include "TestVector.hpp"
+#include "hashpp.h"
 
 using json = nlohmann::json;
 
-static std::pair<std::ifstream, uint32_t> getFile(const std::filesystem::path path) {
+static std::pair<std::ifstream, uintmax_t> getFile(const std::filesystem::path path) {
     std::ifstream file(path, std::ios::binary);
     if (!file.is_open()) throw std::runtime_error("Can't open file: " + path.string());
-    uint32_t sizeofFile = std::filesystem::file_size(path);
+    uintmax_t sizeofFile = std::filesystem::file_size(path);
     return {std::move(file), sizeofFile};
 }
 
-template<typename T>
-static void fillBufferFromFile(std::ifstream& ifs, std::vector<T>& buffer, const uint32_t size) {
+template<typename T, typename Allocator>
+static void fillBufferFromFile(std::ifstream& ifs, std::vector<T, Allocator>& buffer, const uintmax_t size) {
     using buffer_type = std::remove_reference_t<decltype(buffer)>::value_type;
     buffer.resize(size / sizeof(buffer_type));
     ifs.read(reinterpret_cast<char*>(buffer.data()), size);
 }
 
+// Returns the cartesian product of "Parameters" values, "Defines" are appended to defines
+static std::vector<Tester::Test::Specialization> parseSpecializations(const json& data, std::string& defines) {
+    using Specialization = Tester::Test::Specialization;
+    auto toString = [](const json& value) { return value.is_string() ? value.get<std::string>() : value.dump(); };
+    if (data.contains("Defines")) {
+        for (const auto& [name, value] : data["Defines"].items()) { defines += " -D " + name + "=" + toString(value); }
+    }
+    std::vector<Specialization> specializations = {Specialization{}};
+    if (!data.contains("Parameters")) return specializations;
+
+    for (const auto& [name, values] : data["Parameters"].items()) {
+        if (!values.is_array() || values.empty()) {
+            throw std::runtime_error("Error: Specialization parameter should be a non-empty array: " + name);
+        }
+        std::vector<Specialization> product;
+        for (const auto& specialization : specializations) {
+            for (const auto& value : values) {
+                product.push_back(specialization);
+                product.back().parameters.emplace_back(name, toString(value));
+            }
+        }
+        specializations = std::move(product);
+    }
+
+    if (!data.contains("ItemsPerWorkItem")) return specializations;
+    for (auto& specialization : specializations) {
+        for (const auto& name : data["ItemsPerWorkItem"].get<std::vector<std::string>>()) {
+            auto it = std::find_if(specialization.parameters.begin(), specialization.parameters.end(),
+                                   [&](const auto& parameter) { return parameter.first == name; });
+            if (it == specialization.parameters.end()) {
+                throw std::runtime_error("Error: Unknown ItemsPerWorkItem parameter: " + name);
+            }
+            specialization.items_per_work_item *= std::stoul(it->second);
+        }
+    }
+    return specializations;
+}
+
+// "auto", a number or an array of 1-3 numbers, missing key is "auto"
+static std::vector<size_t> parseRange(const json& data, const char* key) {
+    if (!data.contains(key) || data[key] == "auto") return {};
+    const auto& value = data[key];
+    if (!value.is_number_unsigned() && (!value.is_array() || value.empty() || value.size() > 3)) {
+        throw std::runtime_error(std::string("Error: ") + key + " should be \"auto\", a number or an array of 1-3 numbers!");
+    }
+    auto sizes = value.is_array() ? value.get<std::vector<size_t>>() : std::vector<size_t>{value.get<size_t>()};
+    if (std::string_view(key) != "GlobalOffset" && std::find(sizes.begin(), sizes.end(), 0) != sizes.end()) {
+        throw std::runtime_error(std::string("Error: ") + key + " can't be zero!");
+    }
+    return sizes;
+}
+
+// "Arguments" entries: {"Input": index or file}, {"Output": index or buffer name}, {"Scalar": type, "Value": value},
+// {"Local": bytes}. Without "Arguments" the inputs are followed by the outputs that aren't in place
+static std::vector<Tester::Test::Argument> parseArguments(const json& data,
+                                                          const std::vector<Tester::Test::input_type>& inputs,
+                                                          const std::vector<Tester::Test::OutputBuffer>& outputs) {
+    using Argument = Tester::Test::Argument;
+    std::vector<Argument> arguments;
+    auto bufferArgument = [](Argument::Kind kind, size_t index) {
+        return Argument{kind, index, Tester::Test::blob_type::uint32, {}};
+    };
+    if (!data.contains("Arguments")) {
+        for (size_t i = 0; i < inputs.size(); ++i) { arguments.push_back(bufferArgument(Argument::Kind::input, i)); }
+        for (size_t i = 0; i < outputs.size(); ++i) {
+            if (!outputs[i].in_place.has_value()) arguments.push_back(bufferArgument(Argument::Kind::output, i));
+        }
+        return arguments;
+    }
+    auto toString = [](const json& value) { return value.is_string() ? value.get<std::string>() : value.dump(); };
+    auto findBuffer = [](const json& key, size_t count, auto&& name_of) -> size_t {
+        if (key.is_number_unsigned() && key.get<size_t>() < count) return key.get<size_t>();
+        for (size_t i = 0; key.is_string() && i < count; ++i) {
+            if (name_of(i) == key.get<std::string>()) return i;
+        }
+        throw std::runtime_error("Error: Unknown buffer in Arguments: " + key.dump());
+    };
+    for (const auto& entry : data["Arguments"]) {
+        if (entry.contains("Input")) {
+            const auto input =
+                findBuffer(entry["Input"], inputs.size(), [&](size_t i) { return std::get<0>(inputs[i]); });
+            arguments.push_back(bufferArgument(Argument::Kind::input, input));
+        } else if (entry.contains("Output")) {
+            const auto output = findBuffer(entry["Output"], outputs.size(), [&](size_t i) { return outputs[i].name; });
+            arguments.push_back(bufferArgument(Argument::Kind::output, output));
+        } else if (entry.contains("Scalar") && entry.contains("Value")) {
+            const auto type = Tester::Test::getBlobType(entry["Scalar"].get<std::string>());
+            arguments.push_back({Argument::Kind::scalar, 0, type, toString(entry["Value"])});
+        } else if (entry.contains("Local")) {
+            arguments.push_back({Argument::Kind::local, 0, Tester::Test::blob_type::uint32, toString(entry["Local"])});
+        } else {
+            throw std::runtime_error("Error: Argument should be Input, Output, Scalar with Value or Local: " +
+                                     entry.dump());
+        }
+    }
+    // An output that isn't in place is only written through its argument
+    for (size_t i = 0; i < outputs.size(); ++i) {
+        const bool bound = std::any_of(arguments.begin(), arguments.end(), [&](const auto& argument) {
+            return argument.kind == Argument::Kind::output && argument.index == i;
+        });
+        if (!bound && !outputs[i].in_place.has_value()) {
+            throw std::runtime_error("Error: Output buffer \"" + outputs[i].name + "\" isn't in Arguments!");
+        }
+    }
+    return arguments;
+}
+
+// Value with every ${NAME} replaced by the specialization parameter, "a*b" is a product of unsigned numbers
+static std::string substitute(std::string text, const Tester::Test::Specialization& specialization) {
+    for (const auto& [name, value] : specialization.parameters) {
+        const std::string placeholder = "${" + name + "}";
+        for (auto pos = text.find(placeholder); pos != std::string::npos; pos = text.find(placeholder, pos)) {
+            text.replace(pos, placeholder.size(), value);
+            pos += value.size();
+        }
+    }
+    return text;
+}
+
+static uint64_t evaluateProduct(const std::string& text) {
+    uint64_t product = 1;
+    for (size_t begin = 0, end; begin <= text.size(); begin = end + 1) {
+        end = std::min(text.find('*', begin), text.size());
+        size_t parsed = 0;
+        const auto factor = text.substr(begin, end - begin);
+        product *= std::stoull(factor, &parsed);
+        if (parsed != factor.size()) throw std::runtime_error("Error: Wrong argument value: " + text);
+    }
+    return product;
+}
+
+// "Inputs" and "Outputs" of a test or of a case of "Cases", the blobs are loaded by the Test
+static void parseBlobs(const json& data, std::vector<Tester::Test::input_type>& inputs,
+                       std::vector<Tester::Test::OutputBuffer>& outputs) {
+    using Test = Tester::Test;
+    // The blob of an entry is its only key that isn't an attribute
+    auto getBlob = [](const json& entry) {
+        for (auto it = entry.cbegin(); it != entry.cend(); ++it) {
+            if (it.key() != "Buffer" && it.key() != "InPlace") return it;
+        }
+        throw std::runtime_error("Error: Inputs and Outputs entries should have a blob!");
+    };
+
+    std::map<std::string, size_t> in_place_inputs;  // buffer name -> input
+    for (const auto& binary : data.value("Inputs", json::array())) {
+        if (binary.empty()) { continue; }
+        auto it = getBlob(binary);
+        Test::input_type input = {it.key(), Test::getBlobType(it.value()), {}};
+        if (binary.contains("InPlace")) in_place_inputs[binary["InPlace"].get<std::string>()] = inputs.size();
+        inputs.emplace_back(std::move(input));
+    }
+    // Goldens of one "Buffer" are grouped in the order the buffers first appear
+    for (const auto& from : data.value("Outputs", json::array())) {
+        if (from.empty()) { continue; }
+        auto it = getBlob(from);
+        std::string from_name = it.key();
+        auto it_bin = it.value().cbegin();
+        Test::output_type golden = {from_name, {it_bin.key(), Test::getBlobType(it_bin.value()), {}}};
+        const auto buffer_name = from.value("Buffer", "");
+        auto buffer = std::find_if(outputs.begin(), outputs.end(), [&](auto& b) { return b.name == buffer_name; });
+        if (buffer == outputs.end()) buffer = outputs.insert(outputs.end(), {buffer_name, {}, std::nullopt});
+        buffer->goldens.emplace_back(std::move(golden));
+    }
+    for (const auto& [buffer_name, input_id] : in_place_inputs) {
+        auto buffer = std::find_if(outputs.begin(), outputs.end(), [&](auto& b) { return b.name == buffer_name; });
+        if (buffer == outputs.end()) {
+            throw std::runtime_error("Error: In-place buffer \"" + buffer_name + "\" has no goldens in Outputs!");
+        }
+        buffer->in_place = input_id;
+    }
+}
+
 namespace Tester {
-/*static*/ Test Test::parseTest(std::filesystem::path pathToTest) {
+/*static*/ Test Test::parseTest(std::filesystem::path pathToTest, const std::filesystem::path& common_folder) {
     std::vector<fs::path> files;
     for (const auto& test_files : fs::directory_iterator(pathToTest)) {
         if (test_files.is_directory()) {
@@ -32,7 +210,6 @@ namespace Tester {
         files.emplace_back(test_files);
     }
     auto contain_json = [](const fs::path& path) { return path.extension() == ".json"; };
-    auto contain_opencl = [](const fs::path& path) { return path.extension() == ".cl"; };
     {
         auto json_files_in_folder = std::count_if(files.begin(), files.end(), contain_json);
         if (json_files_in_folder > 2) {
@@ -40,79 +217,291 @@ namespace Tester {
         }
         if (json_files_in_folder == 0) { throw std::runtime_error("Error: Can't find .json file in test folder!"); }
     }
-    {
-        auto cl_files_in_folder = std::count_if(files.begin(), files.end(), contain_opencl);
-        if (cl_files_in_folder > 2) {
-            throw std::runtime_error("Error: Only one OpenCl programm should be in test folder!");
-        }
-        if (cl_files_in_folder == 0) { throw std::runtime_error("Error: Can't find .cl file in test folder!"); }
-    }
-    auto cl_file_path = *(std::find_if(files.begin(), files.end(), contain_opencl));
-    std::ifstream opencl_prog_file(cl_file_path);
-    if (!opencl_prog_file) {
-        throw std::runtime_error("Error: Can't open opencl programm!\nPath: " + cl_file_path.string());
-    }
-    std::string openclProgram;
-    auto openClFileSize = fs::file_size(cl_file_path);
-    openclProgram.resize(openClFileSize + 1);
-    opencl_prog_file.read(reinterpret_cast<char*>(openclProgram.data()), openClFileSize);
-
     auto json_file_path = *(std::find_if(files.begin(), files.end(), contain_json));
     std::ifstream json_file(json_file_path);
     if (!json_file) { throw std::runtime_error("Error: Can't open json file!\nPath: " + json_file_path.string()); }
 
     json data = json::parse(json_file);
-    std::vector<Test::input_type> inputs;
-    std::vector<Test::output_type> outputs;
 
-    for (json input = data["Inputs"]; auto& binary : input) {
-        if (binary.empty()) { continue; }
-        auto it = binary.cbegin();
-        Test::input_type input = {it.key(), Test::getBlobType(it.value()), {}};
-        inputs.emplace_back(std::move(input));
+    // Libraries are searched in the test folder and then in the common folder
+    std::vector<fs::path> include_dirs = {pathToTest};
+    if (!common_folder.empty()) include_dirs.push_back(common_folder);
+    std::vector<CompileUnit> libraries;
+    if (data.contains("Libraries")) {
+        for (const auto& library : data["Libraries"]) {
+            const auto name = library.get<std::string>();
+            auto dir = std::find_if(include_dirs.begin(), include_dirs.end(),
+                                    [&](const fs::path& d) { return fs::is_regular_file(d / name); });
+            if (dir == include_dirs.end()) { throw std::runtime_error("Error: Can't find library: " + name); }
+            libraries.emplace_back(CompileUnit::load(*dir / name, include_dirs));
+        }
     }
-    for (json output = data["Outputs"]; auto& from : output) {
-        if (from.empty()) { continue; }
-        auto it = from.cbegin();
-        std::string from_name = it.key();
-        auto it_bin = it.value().cbegin();
-        Test::output_type output = {from_name, {it_bin.key(), Test::getBlobType(it_bin.value()), {}}};
-        outputs.emplace_back(std::move(output));
+    auto contain_opencl = [&](const fs::path& path) {
+        return path.extension() == ".cl" && std::none_of(libraries.begin(), libraries.end(), [&](const auto& lib) {
+                   return lib.name == path.filename().string();
+               });
+    };
+    auto contain_il = [](const fs::path& path) { return path.extension() == ".spv"; };
+
+    // SPIR-V module from "IL" or a single .spv file in the folder takes precedence over OpenCL C source
+    fs::path program_path;
+    if (data.contains("IL")) {
+        program_path = pathToTest / data["IL"].get<std::string>();
+    } else if (auto il_files_in_folder = std::count_if(files.begin(), files.end(), contain_il); il_files_in_folder) {
+        if (il_files_in_folder > 1) {
+            throw std::runtime_error("Error: Only one SPIR-V module should be in test folder! Use \"IL\" to choose.");
+        }
+        program_path = *(std::find_if(files.begin(), files.end(), contain_il));
+    } else {
+        auto cl_files_in_folder = std::count_if(files.begin(), files.end(), contain_opencl);
+        if (cl_files_in_folder > 2) {
+            throw std::runtime_error("Error: Only one OpenCl programm should be in test folder!");
+        }
+        if (cl_files_in_folder == 0) { throw std::runtime_error("Error: Can't find .cl file in test folder!"); }
+        program_path = *(std::find_if(files.begin(), files.end(), contain_opencl));
+    }
+    auto openclProgram = CompileUnit::load(program_path, include_dirs);
+
+    // A batched test takes its blobs from "Cases" instead of "Inputs" and "Outputs", the first case sets the layout
+    const bool batched = data.contains("Cases");
+    if (batched && (!data["Cases"].is_array() || data["Cases"].empty() || data.contains("Inputs") ||
+                    data.contains("Outputs"))) {
+        throw std::runtime_error("Error: Cases should be a non-empty array that replaces Inputs and Outputs!");
     }
-    Test::GPUVenderType vender = Test::GPUVenderType::NVIDIA;
+    std::vector<Test::input_type> inputs;
+    std::vector<Test::OutputBuffer> outputs;
+    parseBlobs(batched ? data["Cases"][0] : data, inputs, outputs);
+    std::optional<Test::GPUVenderType> vender;
     if (data.contains("Disasm")) {
         if (data["Disasm"] == "AMD") { vender = Test::GPUVenderType::AMD; }
         if (data["Disasm"] == "NVIDIA") { vender = Test::GPUVenderType::NVIDIA; }
         if (data["Disasm"] == "INTEL") { vender = Test::GPUVenderType::INTEL; }
     }
-    return Test(std::move(pathToTest), std::move(inputs), std::move(outputs), std::move(openclProgram),
-            json_file_path.stem().string(), vender);
+    Test test(std::move(pathToTest), std::move(inputs), std::move(outputs), std::move(openclProgram),
+              std::move(libraries), json_file_path.stem().string(), vender);
+    if (batched) {
+        const auto& cases = data["Cases"];
+        auto getCaseName = [&](size_t i) { return cases[i].value("Name", "case " + std::to_string(i)); };
+        test.m_cases.push_back({getCaseName(0), {}});
+        for (const auto& buffer : test.m_outputs) { test.m_cases.back().outputs.emplace_back(0, buffer.getSize()); }
+        for (size_t i = 1; i < cases.size(); ++i) {
+            std::vector<Test::input_type> case_inputs;
+            std::vector<Test::OutputBuffer> case_outputs;
+            parseBlobs(cases[i], case_inputs, case_outputs);
+            test.appendCase(getCaseName(i), std::move(case_inputs), std::move(case_outputs));
+        }
+        test.hashInputs();
+    }
+
+    if (data.contains("BuildOptions")) {
+        test.m_build_option_sets = data["BuildOptions"].get<std::vector<std::string>>();
+        if (test.m_build_option_sets.empty()) throw std::runtime_error("Error: BuildOptions list is empty!");
+    }
+    if (data.contains("Specialization")) {
+        if (test.isIL() && data["Specialization"].contains("Parameters")) {
+            throw std::runtime_error("Error: SPIR-V program can't be specialized! Test: " + test.m_name);
+        }
+        test.m_specializations = parseSpecializations(data["Specialization"], test.m_defines);
+    }
+    test.m_ndrange = {parseRange(data, "GlobalSize"), parseRange(data, "LocalSize"), parseRange(data, "GlobalOffset")};
+    const auto& ndrange = test.m_ndrange;
+    const auto dimensions = ndrange.global.empty() ? 1 : ndrange.global.size();  // "auto" global size is 1D
+    if ((!ndrange.local.empty() && ndrange.local.size() != dimensions) ||
+        (!ndrange.offset.empty() && ndrange.offset.size() != dimensions)) {
+        throw std::runtime_error("Error: LocalSize and GlobalOffset should have dimensions of GlobalSize! Test: " +
+                                 test.m_name);
+    }
+    test.m_arguments = parseArguments(data, test.m_inputs, test.m_outputs);
+    test.m_chunked = data.value("Chunked", false);
+    if ((test.m_chunked || batched) && (!ndrange.global.empty() || !ndrange.offset.empty())) {
+        throw std::runtime_error(
+            "Error: Chunked and batched tests should have \"auto\" GlobalSize and no GlobalOffset! Test: " +
+            test.m_name);
+    }
+    return test;
+}
+
+std::vector<Test::Variant> Test::getVariants(const std::vector<std::string>& option_sets) const {
+    const auto& sets = option_sets.empty() ? m_build_option_sets : option_sets;
+    std::vector<Variant> variants;
+    for (const auto& specialization : m_specializations) {
+        std::string defines = m_defines;
+        for (const auto& [name, value] : specialization.parameters) { defines += " -D " + name + "=" + value; }
+        for (const auto& options : sets) {
+            std::string variant_options = options + defines;
+            if (!variant_options.empty() && variant_options.front() == ' ') variant_options.erase(0, 1);
+            variants.push_back({"", std::move(variant_options), specialization});
+        }
+    }
+    if (variants.size() > 1) {
+        for (size_t i = 0; i < variants.size(); ++i) { variants[i].name = "[" + std::to_string(i) + "]"; }
+    }
+    return variants;
 }
 
 Test::Test(std::filesystem::path&& to_test_path, std::vector<input_type>&& inputs,
-                        std::vector<output_type>&& output, std::string&& prog, std::string&& name, GPUVenderType type)
+                        std::vector<OutputBuffer>&& output, CompileUnit&& prog, std::vector<CompileUnit>&& libraries,
+                        std::string&& name, std::optional<GPUVenderType> type)
     : m_inputs(std::move(inputs)), m_outputs(std::move(output)), m_to_test_path(std::move(to_test_path)),
-      m_opencl_program(std::move(prog)), m_name(std::move(name)), m_vendor(type) {
+      m_opencl_program(std::move(prog)), m_libraries(std::move(libraries)), m_name(std::move(name)), m_vendor(type) {
     fillBlobs();
 }
 
 void Test::fillBlobs() {
-    for (auto& input : m_inputs) {
+    loadBlobs(m_inputs, m_outputs);
+    hashInputs();
+}
+
+void Test::hashInputs() {
+    m_input_hashes.clear();
+    for (const auto& input : m_inputs) {
+        const auto& blob = std::get<2>(input);
+        const std::string data(blob.begin(), blob.end());
+        m_input_hashes.push_back(hashpp::get::getHash(hashpp::ALGORITHMS::MD5, data).getString());
+    }
+}
+
+void Test::loadBlobs(std::vector<input_type>& inputs, std::vector<OutputBuffer>& outputs) const {
+    for (auto& input : inputs) {
         auto [ifsteam, file_size] = getFile(m_to_test_path / std::get<0>(input));
         fillBufferFromFile(ifsteam, std::get<2>(input), file_size);
     }
 
-    for (auto& output : m_outputs) {
-        auto [ifsteam, file_size] = getFile(m_to_test_path / std::get<0>(output.second));
-        fillBufferFromFile(ifsteam, std::get<2>(output.second), file_size);
+    for (auto& buffer : outputs) {
+        for (auto& output : buffer.goldens) {
+            auto [ifsteam, file_size] = getFile(m_to_test_path / std::get<0>(output.second));
+            fillBufferFromFile(ifsteam, std::get<2>(output.second), file_size);
+        }
+        auto first_blob_size = buffer.getSize();
+        bool equal_size = std::all_of(buffer.goldens.begin(), buffer.goldens.end(), [&](auto& output) {
+            return first_blob_size == std::get<2>(output.second).size();
+        });
+        if (!equal_size) { throw std::runtime_error("All output blobs should have equal sizes! Test:" + m_name); }
+        if (buffer.in_place.has_value() && std::get<2>(inputs[*buffer.in_place]).size() != first_blob_size) {
+            throw std::runtime_error("In-place input and its goldens should have equal sizes! Test:" + m_name);
+        }
     }
+}
 
-    if (m_outputs.empty()) return;
+void Test::appendCase(std::string name, std::vector<input_type>&& inputs, std::vector<OutputBuffer>&& outputs) {
+    loadBlobs(inputs, outputs);
+    auto sameLayout = [&]() {
+        if (inputs.size() != m_inputs.size() || outputs.size() != m_outputs.size()) return false;
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            if (std::get<1>(inputs[i]) != std::get<1>(m_inputs[i])) return false;
+        }
+        for (size_t b = 0; b < outputs.size(); ++b) {
+            if (outputs[b].name != m_outputs[b].name || outputs[b].in_place != m_outputs[b].in_place ||
+                outputs[b].goldens.size() != m_outputs[b].goldens.size() ||
+                outputs[b].getType() != m_outputs[b].getType()) {
+                return false;
+            }
+        }
+        return true;
+    };
+    if (!sameLayout()) {
+        throw std::runtime_error("Case \"" + name + "\" should have the inputs and outputs of the first case! Test:" +
+                                 m_name);
+    }
+    // Work-item i of the batched dispatch must find the elements of its case at the same place in every blob,
+    // so every blob keeps the ratio to the first output of the first case. Ratios are compared as reduced fractions
+    const size_t reference = outputs.front().getSize(), batched_reference = m_outputs.front().getSize();
+    auto checkRatio = [&](const std::string& blob_name, size_t size, size_t batched_size) {
+        if (reference == 0 || batched_reference == 0) {
+            throw std::runtime_error("Case \"" + name + "\": the first output of a batched case can't be empty! Test:" +
+                                     m_name);
+        }
+        const auto g = std::gcd(size, reference), batched_g = std::gcd(batched_size, batched_reference);
+        if (size / g != batched_size / batched_g || reference / g != batched_reference / batched_g) {
+            throw std::runtime_error("Case \"" + name + "\": " + blob_name + " has " + std::to_string(size) +
+                                     " bytes for " + std::to_string(reference) +
+                                     " bytes of the first output, the sizes of the first case don't keep this ratio! "
+                                     "Test:" + m_name);
+        }
+    };
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        checkRatio("input \"" + std::get<0>(inputs[i]) + "\"", std::get<2>(inputs[i]).size(),
+                   std::get<2>(m_inputs[i]).size());
+    }
+    for (size_t b = 0; b < outputs.size(); ++b) {
+        for (size_t g = 0; g < outputs[b].goldens.size(); ++g) {
+            checkRatio("output \"" + std::get<0>(outputs[b].goldens[g].second) + "\"",
+                       std::get<2>(outputs[b].goldens[g].second).size(),
+                       std::get<2>(m_outputs[b].goldens[g].second).size());
+        }
+    }
+    Case added{std::move(name), {}};
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        auto& blob = std::get<2>(m_inputs[i]);
+        const auto& case_blob = std::get<2>(inputs[i]);
+        blob.insert(blob.end(), case_blob.begin(), case_blob.end());
+    }
+    for (size_t b = 0; b < outputs.size(); ++b) {
+        added.outputs.emplace_back(m_outputs[b].getSize(), outputs[b].getSize());
+        for (size_t g = 0; g < outputs[b].goldens.size(); ++g) {
+            auto& golden = std::get<2>(m_outputs[b].goldens[g].second);
+            const auto& case_golden = std::get<2>(outputs[b].goldens[g].second);
+            golden.insert(golden.end(), case_golden.begin(), case_golden.end());
+        }
+    }
+    m_cases.push_back(std::move(added));
+}
+
+std::vector<std::string> Test::getFailedCases(const std::vector<output_blob>& outputs) const {
+    std::vector<std::string> failed;
+    for (const auto& test_case : m_cases) {
+        for (size_t b = 0; b < m_outputs.size() && b < outputs.size(); ++b) {
+            const auto [offset, size] = test_case.outputs[b];
+            const auto& golden = std::get<2>(m_outputs[b].goldens.front().second);
+            if (outputs[b].size() < offset + size ||
+                !matchesGolden(m_outputs[b].getType(), {golden.data() + offset, size},
+                               {outputs[b].data() + offset, size})) {
+                failed.push_back(test_case.name);
+                break;
+            }
+        }
+    }
+    return failed;
+}
+
+bool Test::matchesGolden(blob_type type, std::span<const uint8_t> golden, std::span<const uint8_t> result) {
+    if (golden.size() != result.size()) return false;
+    if (type != blob_type::float32) return std::equal(golden.begin(), golden.end(), result.begin());
+    for (size_t i = 0; i + sizeof(float) <= golden.size(); i += sizeof(float)) {
+        float expected, actual;
+        std::memcpy(&expected, golden.data() + i, sizeof(float));
+        std::memcpy(&actual, result.data() + i, sizeof(float));
+        if (std::fabs(expected - actual) > std::numeric_limits<float>::epsilon()) return false;
+    }
+    return true;
+}
+
+size_t Test::getFootprint() const noexcept {
+    size_t bytes = 0;
+    for (const auto& input : m_inputs) { bytes += std::get<2>(input).size(); }
+    for (const auto& buffer : m_outputs) {
+        if (!buffer.in_place.has_value()) bytes += buffer.getSize();
+    }
+    return bytes;
+}
+
+std::vector<uint8_t> Test::getScalar(const Argument& argument, const Specialization& specialization) {
+    const auto text = substitute(argument.value, specialization);
+    std::vector<uint8_t> bytes(getTypeSize(argument.type));
+    if (argument.type == blob_type::float32) {
+        const float value = std::stof(text);
+        std::memcpy(bytes.data(), &value, sizeof(value));
+    } else {
+        const auto value = static_cast<uint32_t>(evaluateProduct(text));
+        std::memcpy(bytes.data(), &value, sizeof(value));
+    }
+    return bytes;
+}
 
-    auto first_blob_size = std::get<2>(m_outputs.front().second).size();
-    bool equal_size = std::all_of(m_outputs.begin(), m_outputs.end(),
-                                  [&](auto& output) { return first_blob_size == std::get<2>(output.second).size(); });
-    if (!equal_size) { throw std::runtime_error("All output blobs should have equal sizes! Test:" + m_name); }
+size_t Test::getLocalSize(const Argument& argument, const Specialization& specialization) {
+    const auto bytes = evaluateProduct(substitute(argument.value, specialization));
+    if (bytes == 0) throw std::runtime_error("Error: Local argument can't be zero bytes: " + argument.value);
+    return static_cast<size_t>(bytes);
 }
 
 Test::blob_type Test::getBlobType(std::string_view type) {
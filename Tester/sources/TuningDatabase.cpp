@@ -0,0 +1,72 @@
+#include "TuningDatabase.hpp"
+
+#include <fstream>
+#include <iostream>
+
+#include <json.hpp>
+
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+namespace Tester {
+
+TuningDatabase::TuningDatabase(std::filesystem::path path) : m_path(std::move(path)) {
+    m_path.make_preferred();
+    std::ifstream file(m_path);
+    if (!file.is_open()) return;  // nothing is tuned yet
+    try {
+        const json data = json::parse(file);
+        for (const auto& [key, value] : data.items()) {
+            Entry entry;
+            if (value["LocalSize"] != "auto") entry.local_size = value["LocalSize"].get<std::vector<size_t>>();
+            entry.kernel_time_us = value.value("Microseconds", 0.0);
+            entry.test_name = value.value("Test", "");
+            entry.device_name = value.value("Device", "");
+            m_entries.emplace(key, std::move(entry));
+        }
+    } catch (const std::exception& e) {
+        m_entries.clear();
+        std::cout << "Warning: tuning database is ignored: " << m_path << "\nError: " << e.what() << std::endl;
+    }
+}
+
+std::optional<TuningDatabase::Entry> TuningDatabase::find(const std::string& key) const {
+    std::lock_guard lock(m_mutex);
+    if (auto it = m_entries.find(key); it != m_entries.end()) return it->second;
+    return std::nullopt;
+}
+
+void TuningDatabase::update(const std::string& key, Entry entry) {
+    std::lock_guard lock(m_mutex);
+    m_entries.insert_or_assign(key, std::move(entry));
+}
+
+size_t TuningDatabase::size() const {
+    std::lock_guard lock(m_mutex);
+    return m_entries.size();
+}
+
+void TuningDatabase::save() const {
+    std::lock_guard lock(m_mutex);
+    json data = json::object();
+    for (const auto& [key, entry] : m_entries) {
+        data[key] = {{"Test", entry.test_name},
+                     {"Device", entry.device_name},
+                     {"LocalSize", entry.local_size.empty() ? json("auto") : json(entry.local_size)},
+                     {"Microseconds", entry.kernel_time_us}};
+    }
+    auto tmp_path = m_path;
+    tmp_path += ".tmp";
+    {
+        std::ofstream file(tmp_path, std::ios::trunc);
+        if (!(file << data.dump(4))) {
+            std::cout << "Warning: Can't write tuning database: " << tmp_path << std::endl;
+            return;
+        }
+    }
+    std::error_code ec;
+    fs::rename(tmp_path, m_path, ec);
+    if (ec) std::cout << "Warning: Can't write tuning database: " << m_path << std::endl;
+}
+
+}  // namespace Tester
@@ -1,22 +1,112 @@
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
 #include <locale>
+#include <string>
+#include <string_view>
 
 #include "Application.hpp"
 
-static void start(const char* pathToFolder) {
-    Tester::Application app;
-    app.parseTestFolder(pathToFolder);
-    app.runTests();
-}
-
 struct ParsedArguments {
     const char* pathToBinariesFolder = "";
+    Tester::Settings settings;
 };
 
-ParsedArguments parseCLI(const int argc, char** args) noexcept {
+static void start(const ParsedArguments& arguments) {
+    Tester::Application app(arguments.settings);
+    app.parseTestFolder(arguments.pathToBinariesFolder);
+    app.runTests();
+}
+
+// Device selection for CI and build farm nodes, the command line overrides it
+void applyEnvironment(Tester::Settings& settings) {
+    if (const char* value = std::getenv("TESTER_DEVICE_TYPE")) settings.device_type = value;
+    if (const char* value = std::getenv("TESTER_PLATFORM")) settings.platform_filter = value;
+    if (const char* value = std::getenv("TESTER_DEVICE")) settings.device_filter = value;
+    if (const char* value = std::getenv("TESTER_DEVICE_INDEX")) settings.device_index = std::stoul(value);
+}
+
+ParsedArguments parseCLI(const int argc, char** args) {
     ParsedArguments arguments;
-    if (argc == 2) {
-        arguments.pathToBinariesFolder = args[1];
+    applyEnvironment(arguments.settings);
+    auto nextValue = [&](int& i) -> std::string_view {
+        if (i + 1 >= argc) throw std::runtime_error("Missing value for argument: " + std::string(args[i]));
+        return args[++i];
+    };
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = args[i];
+        if (arg == "--device-type") {  // all, gpu, cpu or accelerator
+            arguments.settings.device_type = nextValue(i);
+        } else if (arg == "--platform") {  // regex of the platform name
+            arguments.settings.platform_filter = nextValue(i);
+        } else if (arg == "--device") {  // regex of the device name
+            arguments.settings.device_filter = nextValue(i);
+        } else if (arg == "--device-index") {
+            arguments.settings.device_index = std::stoul(std::string(nextValue(i)));
+        } else if (arg == "--no-cpu-fallback") {
+            arguments.settings.cpu_fallback = false;
+        } else if (arg == "--partition") {  // equally:N, counts:A,B,... or affinity:DOMAIN
+            arguments.settings.partition = nextValue(i);
+        } else if (arg == "--distribute") {
+            arguments.settings.distribute_tests = true;
+        } else if (arg == "--cache-dir") {
+            arguments.settings.program_cache_dir = nextValue(i);
+        } else if (arg == "--cache-size") {  // MiB
+            arguments.settings.program_cache_size_limit = std::stoull(std::string(nextValue(i))) * 1024 * 1024;
+        } else if (arg == "--no-cache") {
+            arguments.settings.use_program_cache = false;
+        } else if (arg == "--build-options") {  // option sets separated by ';'
+            std::string_view sets = nextValue(i);
+            for (size_t pos = 0; pos <= sets.size();) {
+                const auto end = std::min(sets.find(';', pos), sets.size());
+                arguments.settings.build_option_sets.emplace_back(sets.substr(pos, end - pos));
+                pos = end + 1;
+            }
+        } else if (arg == "--build-threads") {
+            arguments.settings.build_threads = std::stoul(std::string(nextValue(i)));
+        } else if (arg == "--autotune") {
+            arguments.settings.autotune = true;
+        } else if (arg == "--tuning-db") {
+            arguments.settings.tuning_db_path = nextValue(i);
+        } else if (arg == "--no-tuning-db") {
+            arguments.settings.use_tuning_db = false;
+        } else if (arg == "--pipeline-depth") {
+            arguments.settings.pipeline_depth = std::stoul(std::string(nextValue(i)));
+        } else if (arg == "--queues") {
+            arguments.settings.queue_count = std::stoul(std::string(nextValue(i)));
+        } else if (arg == "--device-memory") {  // % of the global memory
+            arguments.settings.device_memory_percent = std::stoul(std::string(nextValue(i)));
+        } else if (arg == "--host-memory") {  // MiB, 0 - unlimited
+            arguments.settings.host_memory_budget = std::stoull(std::string(nextValue(i))) * 1024 * 1024;
+        } else if (arg == "--chunk-size") {  // MiB per buffer
+            arguments.settings.chunk_size = std::stoull(std::string(nextValue(i))) * 1024 * 1024;
+        } else if (arg == "--buffers") {  // pool, arena or none
+            arguments.settings.buffer_allocation = nextValue(i);
+        } else if (arg == "--buffer-pool") {  // MiB of idle buffers
+            arguments.settings.buffer_pool_limit = std::stoull(std::string(nextValue(i))) * 1024 * 1024;
+        } else if (arg == "--input-cache") {  // MiB per device, 0 - disabled
+            arguments.settings.input_cache_size = std::stoull(std::string(nextValue(i))) * 1024 * 1024;
+        } else if (arg == "--zero-copy") {  // auto, on or off
+            arguments.settings.zero_copy = nextValue(i);
+        } else if (arg == "--svm") {
+            arguments.settings.svm = true;
+        } else if (arg == "--benchmark") {
+            arguments.settings.benchmark = true;
+        } else if (arg == "--no-calibration") {
+            arguments.settings.calibrate = false;
+        } else if (arg == "--warmup") {
+            arguments.settings.warmup_iterations = std::stoul(std::string(nextValue(i)));
+        } else if (arg == "--iterations") {  // 0 - until the confidence interval is tight
+            arguments.settings.benchmark_iterations = std::stoul(std::string(nextValue(i)));
+        } else if (arg == "--max-iterations") {
+            arguments.settings.max_benchmark_iterations = std::stoul(std::string(nextValue(i)));
+        } else if (arg == "--precision") {  // relative half-width of the confidence interval, e.g. 0.02
+            arguments.settings.benchmark_precision = std::stod(std::string(nextValue(i)));
+        } else if (arg.starts_with("--")) {
+            throw std::runtime_error("Unknown argument: " + std::string(arg));
+        } else {
+            arguments.pathToBinariesFolder = args[i];
+        }
     }
     return arguments;
 }
@@ -33,8 +123,10 @@ int main(int argc, char** args) {
     setGlobalLocale();
     try {
         ParsedArguments arguments = parseCLI(argc, args);
-        arguments.pathToBinariesFolder = "C:/Users/Denis/source/repos/opencl_programs/OpenCL_programs/Tests";
-        start(arguments.pathToBinariesFolder);
+        if (std::string_view(arguments.pathToBinariesFolder).empty()) {
+            arguments.pathToBinariesFolder = "C:/Users/Denis/source/repos/opencl_programs/OpenCL_programs/Tests";
+        }
+        start(arguments);
     } catch (const std::exception& e) { std::cerr << "[Error] " << e.what() << std::endl; }
 
     system("pause");
@@ -0,0 +1,9 @@
+__kernel void AddSubInPlace(
+__global uint* a,
+__global const uint* b,
+__global uint* diff)
+{
+    const uint i = get_global_id(0);
+    diff[i] = a[i] - b[i];
+    a[i] += b[i];
+}
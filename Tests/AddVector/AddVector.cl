@@ -0,0 +1,21 @@
+// VEC elements per vector access, UNROLL vector accesses per work-item
+#if VEC == 1
+#define LOAD(i, p) (p)[i]
+#define STORE(v, i, p) (p)[i] = (v)
+#else
+#define LOAD(i, p) vload${VEC}(i, p)
+#define STORE(v, i, p) vstore${VEC}(v, i, p)
+#endif
+
+__kernel void AddVector(
+__global const uint* a,
+__global const uint* b,
+__global uint* out)
+{
+    // Buffers hold the chunk of the dispatch only, see "Chunked" in AddVector.json
+    const size_t base = (get_global_id(0) - get_global_offset(0)) * UNROLL;  // UNROLL is a compile-time constant
+    for (int u = 0; u < UNROLL; ++u) {
+        const size_t i = base + u;
+        STORE(LOAD(i, a) + LOAD(i, b), i, out);
+    }
+}
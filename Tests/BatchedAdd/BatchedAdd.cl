@@ -0,0 +1,8 @@
+__kernel void BatchedAdd(
+__global const uint* a,
+__global const uint* b,
+__global uint* out)
+{
+    const uint i = get_global_id(0);
+    out[i] = a[i] + b[i];
+}
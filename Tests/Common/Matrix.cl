@@ -0,0 +1,11 @@
+#include "Matrix.h"
+
+float4 mult(__constant float* mat, float4 vec)
+{
+    float dot0 = dot(vload4(0, mat), vec);
+    float dot1 = dot(vload4(1, mat), vec);
+    float dot2 = dot(vload4(2, mat), vec);
+    float dot3 = dot(vload4(3, mat), vec);
+
+    return (float4)(dot0, dot1, dot2, dot3);
+}
@@ -0,0 +1,7 @@
+#ifndef MATRIX_H
+#define MATRIX_H
+
+// Row-major 4x4 matrix * column vector
+float4 mult(__constant float* mat, float4 vec);
+
+#endif
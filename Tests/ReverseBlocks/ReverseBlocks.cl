@@ -0,0 +1,17 @@
+__kernel void ReverseBlocks(
+__global const uint* in,
+__local uint* tile,
+const uint count,
+__global uint* out)
+{
+    const uint i = get_global_id(0);
+    const uint lid = get_local_id(0);
+    const uint size = get_local_size(0);
+#if USE_LOCAL
+    tile[lid] = in[i];
+    barrier(CLK_LOCAL_MEM_FENCE);
+    if (i < count) out[i] = tile[size - 1 - lid];
+#else
+    if (i < count) out[i] = in[i - lid + size - 1 - lid];
+#endif
+}